@@ -172,8 +172,7 @@ void AnimatedSprite::update(sf::Time deltaTime)
 	}
 }
 
-void AnimatedSprite::draw(sf::RenderTarget &target,
-			  sf::RenderStates states) const
+void AnimatedSprite::draw(render::Target &target, sf::RenderStates states) const
 {
 	if (this->animation && this->texture) {
 		states.transform *= this->getTransform();
@@ -181,3 +180,12 @@ void AnimatedSprite::draw(sf::RenderTarget &target,
 		target.draw(this->vertices, 4, sf::Quads, states);
 	}
 }
+
+void AnimatedSprite::draw(sf::RenderTarget &target,
+			  sf::RenderStates states) const
+{
+	// Lets the sprite still be drawn with window.draw(sprite)
+
+	render::SfmlTarget sfmlTarget(target);
+	this->draw(sfmlTarget, states);
+}
@@ -9,6 +9,7 @@
 #include <iostream>
 
 #include "animation.hpp"
+#include "render/target.hpp"
 
 class AnimatedSprite : public sf::Drawable, public sf::Transformable
 {
@@ -32,6 +33,7 @@ class AnimatedSprite : public sf::Drawable, public sf::Transformable
 	bool isPlaying() const;
 	sf::Time getFrameTime() const;
 	void setFrame(std::size_t newFrame, bool resetTime = true);
+	void draw(render::Target &target, sf::RenderStates states) const;
 
     private:
 	const Animation *animation;
@@ -38,3 +38,24 @@ const sf::IntRect &Animation::getFrame(std::size_t n) const
 
 	return this->frames[n];
 }
+
+bool Animation::useAtlas(const TextureAtlas &atlas, const std::string &name)
+{
+	// Point the frames at the spritesheet's region in an atlas page,
+	// call this once after all frames have been added.
+
+	const TextureAtlas::Region *region = atlas.find(name);
+
+	if (region == nullptr) {
+		return false;
+	}
+
+	for (sf::IntRect &frame : this->frames) {
+		frame.left += region->rect.left;
+		frame.top += region->rect.top;
+	}
+
+	this->texture = &atlas.getPage(region->page);
+
+	return true;
+}
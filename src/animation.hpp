@@ -3,8 +3,11 @@
 
 #include <SFML/Graphics/Rect.hpp>
 #include <SFML/Graphics/Texture.hpp>
+#include <string>
 #include <vector>
 
+#include "texture_atlas.hpp"
+
 class Animation
 {
     public:
@@ -15,6 +18,7 @@ class Animation
 	const sf::Texture *getSpriteSheet() const;
 	std::size_t getSize() const;
 	const sf::IntRect &getFrame(std::size_t n) const;
+	bool useAtlas(const TextureAtlas &atlas, const std::string &name);
 
     private:
 	std::vector<sf::IntRect> frames;
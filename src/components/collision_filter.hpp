@@ -0,0 +1,18 @@
+#ifndef COMPONENTS_COLLISION_FILTER_HPP
+#define COMPONENTS_COLLISION_FILTER_HPP
+
+#include <cstdint>
+
+// Bodies without one are in category 1 and collide with everything.
+struct CollisionFilter {
+	std::uint32_t category = 1; // Bits this body belongs to.
+	std::uint32_t mask = 0xFFFFFFFF; // Bits this body collides with.
+};
+
+// Both sides have to accept the other.
+inline bool shouldCollide(const CollisionFilter &a, const CollisionFilter &b)
+{
+	return (a.category & b.mask) != 0 && (b.category & a.mask) != 0;
+}
+
+#endif
@@ -5,6 +5,8 @@
 
 struct Transform {
 	sf::Vector2f position;
+	// Position at the start of the current tick, drawn positions are blended between them.
+	sf::Vector2f previousPosition;
 };
 
 #endif
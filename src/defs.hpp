@@ -1,8 +1,38 @@
 #ifndef DEFS_HPP
 #define DEFS_HPP
 
-// Maximums (can be increased, max values are for testing mainly).
+// Maximums (can be increased, max values are for testing mainly). The physics benchmarks in
+// tests/ build with more entities.
+#ifndef DEF_MAX_ENTITIES
 #define DEF_MAX_ENTITIES 5000
+#endif
 #define DEF_MAX_COMPONENTS 32
 
+// Fixed simulation ticks per second, independent of the display's refresh rate.
+#define DEF_TICK_RATE 60
+// Ticks run per frame at most when catching up, the rest of the backlog is dropped.
+#define DEF_MAX_CATCHUP_TICKS 5
+
+// Bodies slower than this (pixels per second) for DEF_SLEEP_TICKS ticks stop being simulated.
+#define DEF_SLEEP_VELOCITY 2.0f
+#define DEF_SLEEP_TICKS 30
+
+// Box2D works in meters, this many pixels make one.
+#define DEF_PIXELS_PER_METER 32.0f
+#define DEF_BOX2D_VELOCITY_ITERATIONS 8
+#define DEF_BOX2D_POSITION_ITERATIONS 3
+
+// Map layers with more tiles than this (and every layer of an infinite map) keep only the
+// chunks around the view resident.
+#define DEF_STREAM_TILES (1024 * 1024)
+// Chunks around the visible ones built ahead of the camera.
+#define DEF_CHUNK_PREFETCH 2
+// Bytes of chunk vertices streamed layers may keep resident.
+#define DEF_CHUNK_BUDGET (32 * 1024 * 1024)
+
+// Threads maps are parsed and their images decoded on.
+#define DEF_LOADER_THREADS 2
+// Milliseconds a frame may spend uploading a loading map's textures.
+#define DEF_UPLOAD_BUDGET_MS 4
+
 #endif
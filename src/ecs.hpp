@@ -382,6 +382,13 @@ public:
 		return mComponentManager->getComponent<T>(entity);
 	}
 
+	template <typename T>
+	bool hasComponent(Entity entity)
+	{
+		return mEntityManager->getSignature(entity).test(
+		    mComponentManager->getComponentType<T>());
+	}
+
 	template <typename T>
 	ComponentType getComponentType()
 	{
@@ -1,7 +1,11 @@
 #include "game.hpp"
+#include "debug.hpp"
+#include "defs.hpp"
 #include "game_state.hpp"
 
+#include <algorithm>
 #include <sstream>
+#include <thread>
 
 void Game::loadTextures()
 {
@@ -46,8 +50,6 @@ GameState *Game::peekState()
 
 void Game::gameLoop()
 {
-	sf::Clock clock;
-
 	// Temporary font for FPS display.
 	sf::Font font;
 	if (!font.loadFromFile(this->selfLocation.string() +
@@ -57,13 +59,37 @@ void Game::gameLoop()
 		return;
 	}
 
+	if (this->threadedRendering) {
+		gameLoopThreaded(font);
+	} else {
+		gameLoopSerial(font);
+	}
+
+	if (this->window.isOpen()) {
+		this->window.close();
+	}
+}
+
+void Game::quit()
+{
+	// Stop the loop, the window is closed once the render thread is done with it
+
+	this->running = false;
+}
+
+void Game::gameLoopSerial(const sf::Font &font)
+{
+	sf::Clock clock;
+
 	sf::Text text;
 	text.setFont(font);
-	text.setString("FPS: 0.0000");
 	text.setCharacterSize(16);
 	text.setFillColor(sf::Color::White);
 
-	while (this->window.isOpen()) {
+	render::SfmlTarget target(this->window);
+	render::Snapshot &frame = this->snapshots.writeBuffer();
+
+	while (this->running && this->window.isOpen()) {
 		sf::Time elapsed = clock.restart();
 
 		GameState *currentState = peekState();
@@ -73,27 +99,152 @@ void Game::gameLoop()
 		}
 
 		currentState->handleInput();
-		currentState->update(elapsed);
+		currentState->setInterpolation(step(currentState, elapsed));
 
+		currentState->prepareFrame();
 		this->window.clear(sf::Color::Black);
 
-		currentState->draw(elapsed);
+		frame.clear();
+		if (currentState->snapshot(frame)) {
+			frame.replay(target);
+		} else {
+			currentState->draw(elapsed);
+		}
 
-		sf::Vector2f viewportTopLeft =
-		    this->window.mapPixelToCoords(sf::Vector2i(0, 0), this->window.getView());
+		std::ostringstream ss;
+		ss << "FPS: " << (1000000.0f / std::max<sf::Int64>(1, elapsed.asMicroseconds()))
+		   << " UPS: " << this->ups;
+		drawHud(text, ss.str());
+
+		this->window.display();
+	}
+}
+
+void Game::gameLoopThreaded(const sf::Font &font)
+{
+	// The render thread takes over the window's context, events are still polled here.
+	this->window.setActive(false);
+	std::thread renderThread(&Game::renderLoop, this, std::cref(font));
+
+	sf::Clock clock;
+	sf::Time tick = sf::seconds(1.f / this->tickRate);
+
+	while (this->running && this->window.isOpen()) {
+		sf::Time elapsed = clock.restart();
+
+		GameState *currentState = peekState();
+
+		if (currentState == nullptr) {
+			continue;
+		}
+
+		currentState->handleInput();
+		currentState->setInterpolation(step(currentState, elapsed));
+
+		render::Snapshot &frame = this->snapshots.writeBuffer();
+		frame.clear();
+
+		if (!currentState->snapshot(frame)) {
+			dbg::printMessage("Game state can't be rendered on a separate thread.",
+					  dbg::Urgency::ERROR);
+			this->running = false;
+			break;
+		}
 
 		std::ostringstream ss;
-		ss << (1000000.0f / clock.restart().asMicroseconds());
-		text.setString("FPS: " + ss.str());
-		text.setPosition(viewportTopLeft);
+		ss << "UPS: " << this->ups;
+		frame.hudText = ss.str();
 
-		this->window.draw(text);
+		this->snapshots.publish();
+
+		// Without the vsync wait the simulation would spin, sleep until the next tick.
+		sf::sleep(tick - this->accumulator - clock.getElapsedTime());
+	}
+
+	this->running = false;
+	renderThread.join();
+
+	this->window.setActive(true);
+}
+
+float Game::step(GameState *state, sf::Time elapsed)
+{
+	// Run as many fixed ticks as the elapsed time covers, returns how far into the next
+	// tick the frame is for interpolation
+
+	sf::Time tick = sf::seconds(1.f / this->tickRate);
+	this->accumulator += elapsed;
+
+	int ticks = 0;
+	while (this->accumulator >= tick && ticks < DEF_MAX_CATCHUP_TICKS) {
+		state->update(tick);
+		this->accumulator -= tick;
+		ticks++;
+	}
+
+	// Too far behind, slow down instead of spiralling.
+	if (this->accumulator >= tick) {
+		this->accumulator %= tick;
+	}
+
+	this->ticksCounted += ticks;
+	if (this->upsClock.getElapsedTime() >= sf::seconds(1.f)) {
+		this->ups = this->ticksCounted / this->upsClock.restart().asSeconds();
+		this->ticksCounted = 0;
+	}
+
+	return this->accumulator / tick;
+}
+
+void Game::renderLoop(const sf::Font &font)
+{
+	this->window.setActive(true);
+
+	render::SfmlTarget target(this->window);
+	sf::Clock clock;
+
+	sf::Text text;
+	text.setFont(font);
+	text.setCharacterSize(16);
+	text.setFillColor(sf::Color::White);
+
+	while (this->running) {
+		// The states are only pushed and popped before the loops start.
+		GameState *currentState = peekState();
+		if (currentState != nullptr) {
+			currentState->prepareFrame();
+		}
+
+		// Keeps drawing the previous snapshot if the simulation hasn't produced a new one.
+		this->snapshots.consume();
+		const render::Snapshot &frame = this->snapshots.readBuffer();
+
+		this->window.clear(sf::Color::Black);
+		frame.replay(target);
+
+		std::ostringstream ss;
+		sf::Int64 frameTime = std::max<sf::Int64>(1, clock.restart().asMicroseconds());
+		ss << "FPS: " << (1000000.0f / frameTime) << " " << frame.hudText;
+		drawHud(text, ss.str());
 
 		this->window.display();
 	}
+
+	this->window.setActive(false);
+}
+
+void Game::drawHud(sf::Text &text, const std::string &hudText)
+{
+	sf::Vector2f viewportTopLeft =
+	    this->window.mapPixelToCoords(sf::Vector2i(0, 0), this->window.getView());
+
+	text.setString(hudText);
+	text.setPosition(viewportTopLeft);
+
+	this->window.draw(text);
 }
 
-Game::Game()
+Game::Game() : tickRate(DEF_TICK_RATE)
 {
 	this->loadTextures();
 
@@ -3,12 +3,16 @@
 
 #include <SFML/Graphics.hpp>
 #include <SFML/System.hpp>
+#include <atomic>
 #include <boost/filesystem/path.hpp>
 #include <iostream>
 #include <map>
 #include <stack>
 #include <string>
 
+#include "render/snapshot.hpp"
+#include "render/triple_buffer.hpp"
+
 // #include "common_functions.hpp"
 
 class GameState;
@@ -28,10 +32,37 @@ class Game
 
 	boost::filesystem::path selfLocation;
 
+	// Set before gameLoop, draws on a dedicated thread while the next frame is simulated.
+	bool threadedRendering = false;
+
+	// Simulation ticks per second, set before gameLoop.
+	unsigned int tickRate;
+
+	// Threads the physics solves islands on, set before gameLoop.
+	unsigned int physicsThreads = 1;
+
+	// Simulate with Box2D instead of the built in rigid body physics, set before gameLoop.
+	bool box2dPhysics = false;
+
 	void gameLoop();
+	void quit();
 
     private:
 	void loadTextures();
+
+	void gameLoopSerial(const sf::Font &font);
+	void gameLoopThreaded(const sf::Font &font);
+	void renderLoop(const sf::Font &font);
+	void drawHud(sf::Text &text, const std::string &hudText);
+	float step(GameState *state, sf::Time elapsed);
+
+	sf::Time accumulator;
+	sf::Clock upsClock;
+	unsigned int ticksCounted = 0;
+	float ups = 0.f;
+
+	std::atomic<bool> running{true};
+	render::TripleBuffer<render::Snapshot> snapshots;
 };
 
 #endif
@@ -4,6 +4,7 @@
 #include <SFML/Graphics/View.hpp>
 
 #include "game.hpp"
+#include "render/snapshot.hpp"
 
 class GameState
 {
@@ -15,7 +16,26 @@ public:
 	Game *game;
 
 	virtual void draw(const sf::Time deltaTime) = 0;
+
+	// Called before every frame on the thread that draws, for GPU work like texture uploads.
+	// With threaded rendering it runs while update and snapshot run on the other thread.
+	virtual void prepareFrame()
+	{
+	}
+
+	// Record the frame instead of drawing it, return false if the state can't.
+	virtual bool snapshot(render::Snapshot &)
+	{
+		return false;
+	}
+
+	// Called with a fixed step, see Game::tickRate.
 	virtual void update(const sf::Time deltaTime) = 0;
+
+	// How far between the last two ticks the next frame should be drawn, 0 to 1.
+	virtual void setInterpolation(float)
+	{
+	}
 	virtual void handleInput() = 0;
 };
 
@@ -2,19 +2,25 @@
 #define GAME_STATES_GAME_ECS_TEST_HPP
 
 #include <SFML/Graphics/Color.hpp>
+#include <atomic>
 #include <cmath>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <vector>
 
 #include "../debug.hpp"
+#include "../defs.hpp"
 #include "../ecs.hpp"
 #include "../game_state.hpp"
+#include "../texture_atlas.hpp"
 #include "../texture_manager.hpp"
+#include "../tmx-parser/map-loader.hpp"
 #include "../tmx-parser/map.hpp"
 
 #include "../systems/player_system.hpp"
 #include "../systems/render_system.hpp"
+#include "../systems/box2d_physics_system.hpp"
 #include "../systems/rigid_physics_system.hpp"
 
 struct Player;	    // ../components/player.hpp
@@ -22,6 +28,7 @@ struct MovementNew; // ../components/movement.hpp
 struct Renderable;  // ../components/renderable.hpp
 struct RigidBody;   // ../components/rigidbody.hpp
 struct Transform;   // ../components/transform.hpp
+struct CollisionFilter; // ../components/collision_filter.hpp
 
 class GameEcsTest : public GameState
 {
@@ -30,7 +37,9 @@ public:
 	{
 		// Initialize values.
 		this->game = game;
-		this->map = tmx::Map(".", "resources/maps/untitled.tmx");
+
+		// The map loads in the background, see prepareFrame.
+		mMapHandle = mMapLoader.load(".", "resources/maps/untitled.tmx");
 		dbg::printMessage("Initialization done.", dbg::Urgency::DEFAULT);
 
 		// Set the game view.
@@ -49,6 +58,7 @@ public:
 		mCoordinator.registerComponent<Renderable>();
 		mCoordinator.registerComponent<RigidBody>();
 		mCoordinator.registerComponent<MovementNew>();
+		mCoordinator.registerComponent<CollisionFilter>();
 		dbg::printMessage("Registered components.", dbg::Urgency::DEFAULT);
 
 		// Render System
@@ -82,29 +92,36 @@ public:
 		mPlayerSystem->init(&mCoordinator, game);
 		dbg::printMessage("Setup player system.", dbg::Urgency::DEFAULT);
 
-		// Rigid Physics System
-		mRigidPhysicsSystem = mCoordinator.registerSystem<RigidPhysicsSystem>();
-		{
-			ecs::Signature signature;
-
-			signature.set(mCoordinator.getComponentType<RigidBody>());
-			signature.set(mCoordinator.getComponentType<Transform>());
-			signature.set(mCoordinator.getComponentType<Renderable>());
-
-			mCoordinator.setSystemSignature<RigidPhysicsSystem>(signature);
+		// Physics, only one of the two backends is registered.
+		ecs::Signature physicsSignature;
+		physicsSignature.set(mCoordinator.getComponentType<RigidBody>());
+		physicsSignature.set(mCoordinator.getComponentType<Transform>());
+		physicsSignature.set(mCoordinator.getComponentType<Renderable>());
+
+		if (game->box2dPhysics) {
+			mBox2DPhysicsSystem = mCoordinator.registerSystem<Box2DPhysicsSystem>();
+			mCoordinator.setSystemSignature<Box2DPhysicsSystem>(physicsSignature);
+			mBox2DPhysicsSystem->init(&mCoordinator, game);
+			dbg::printMessage("Setup Box2D physics system.", dbg::Urgency::DEFAULT);
+		} else {
+			mRigidPhysicsSystem = mCoordinator.registerSystem<RigidPhysicsSystem>();
+			mCoordinator.setSystemSignature<RigidPhysicsSystem>(physicsSignature);
+			mRigidPhysicsSystem->init(&mCoordinator, game);
+			mRigidPhysicsSystem->setThreadCount(game->physicsThreads);
+			dbg::printMessage("Setup rigid body physics system.",
+					  dbg::Urgency::DEFAULT);
 		}
-		mRigidPhysicsSystem->init(&mCoordinator, game);
-		dbg::printMessage("Setup rigid body physics system.", dbg::Urgency::DEFAULT);
 
 		// Create a test entity that is controllable.
 		// clang-format off
 		ecs::Entity entity = mCoordinator.createEntity();
 		mCoordinator.addComponent(entity, Player{
-			.maxWalkSpeed = 2.0f,
-			.maxRunSpeed = 4.0f,
+			.maxWalkSpeed = 120.0f,
+			.maxRunSpeed = 240.0f,
 		});
 		mCoordinator.addComponent(entity, Transform{
 			.position = sf::Vector2f(0.0f, 0.0f),
+			.previousPosition = sf::Vector2f(0.0f, 0.0f),
 		});
 		mCoordinator.addComponent(entity, Renderable{
 			.color = sf::Color::White,
@@ -120,8 +137,8 @@ public:
 		});
 		mCoordinator.addComponent(entity, RigidBody{
 			.velocity = sf::Vector2f(0.0f, 0.0f),
-			.acceleration = sf::Vector2f(0.1f, 0.1f),
-			.deceleration = sf::Vector2f(0.25f, 0.25f),
+			.acceleration = sf::Vector2f(360.0f, 360.0f),
+			.deceleration = sf::Vector2f(900.0f, 900.0f),
 		});
 		mEntities.push_back(entity);
 		// clang-format on
@@ -131,6 +148,7 @@ public:
 		ecs::Entity entityTwo = mCoordinator.createEntity();
 		mCoordinator.addComponent(entityTwo, Transform{
 			.position = sf::Vector2f(1.0f, 15.0f),
+			.previousPosition = sf::Vector2f(1.0f, 15.0f),
 		});
 		mCoordinator.addComponent(entityTwo, Renderable{
 			.color = sf::Color::Red,
@@ -138,36 +156,90 @@ public:
 		});
 		mCoordinator.addComponent(entityTwo, RigidBody{
 			.velocity = sf::Vector2f(0.0f, 0.0f),
-			.acceleration = sf::Vector2f(0.1f, 0.1f),
-			.deceleration = sf::Vector2f(0.25f, 0.25f),
+			.acceleration = sf::Vector2f(360.0f, 360.0f),
+			.deceleration = sf::Vector2f(900.0f, 900.0f),
 		});
 		mEntities.push_back(entityTwo);
 		// clang-format on
+	}
 
-		// Initialize spawns at the end of the constructor
-		mPlayerSystem->initSpawns();
-		dbg::printMessage("Initialized spawns.", dbg::Urgency::DEFAULT);
+	virtual void prepareFrame()
+	{
+		// Texture uploads and the atlas need the GL context, so the map is finished here
+		// and pollLoader hands it to the simulation.
+
+		if (mMapReady) {
+			return;
+		}
+
+		mMapLoader.upload(sf::milliseconds(DEF_UPLOAD_BUDGET_MS));
+
+		if (!mMapLoader.isReady(mMapHandle)) {
+			return;
+		}
+
+		std::vector<sf::Image> images;
+		mLoadedMap = mMapLoader.take(mMapHandle, &images);
+		dbg::printMessage("Map loaded.", dbg::Urgency::DEFAULT);
+
+		unsigned int bindsBefore = countTextureBinds(mLoadedMap);
+		loadAtlas(mLoadedMap, images);
+		unsigned int bindsAfter = countTextureBinds(mLoadedMap);
+
+		std::ostringstream msg;
+		msg << "Texture atlas ready, drawing the map in view switches textures "
+		    << bindsBefore << " time(s) a frame without it and " << bindsAfter
+		    << " with it.";
+		dbg::printMessage(msg.str().c_str(), dbg::Urgency::DEFAULT);
+
+		mMapReady = true;
 	}
 
 	virtual void draw(const sf::Time deltaTime)
 	{
-		this->game->window.clear(sf::Color::Black);
-		this->game->window.setView(this->mGameView);
+		render::SfmlTarget target(this->game->window);
+		pollLoader();
 
-		sf::Vector2f viewportTopLeft = this->game->window.mapPixelToCoords(
-		    sf::Vector2i(0, 0), this->game->window.getView());
-		sf::Vector2f viewportSize = this->game->window.getView().getSize();
-		sf::Rect<float> viewport(viewportTopLeft, viewportSize);
+		if (mLoaded) {
+			drawTo(target);
+		} else {
+			drawLoading(target);
+		}
+	}
 
-		// Updating the render system draws it.
-		// We pass the map so we can draw/sort the map as well.
-		mRenderSystem->draw(&this->map, sf::Clock().restart(), viewport);
+	virtual bool snapshot(render::Snapshot &snapshot)
+	{
+		pollLoader();
+
+		if (mLoaded) {
+			drawTo(snapshot);
+		} else {
+			drawLoading(snapshot);
+		}
+
+		return true;
 	}
 
 	virtual void update(const sf::Time deltaTime)
 	{
-		mPlayerSystem->update(&mGameView);
-		mRigidPhysicsSystem->update(&map);
+		// Nothing to simulate until the map is in.
+		if (!mLoaded) {
+			return;
+		}
+
+		mRenderSystem->beginTick();
+		mPlayerSystem->update(deltaTime);
+		if (mBox2DPhysicsSystem) {
+			mBox2DPhysicsSystem->update(&map, deltaTime);
+		} else {
+			mRigidPhysicsSystem->update(&map, deltaTime);
+		}
+		this->map.update(deltaTime);
+	}
+
+	virtual void setInterpolation(float alpha)
+	{
+		mInterpolation = alpha;
 	}
 
 	virtual void handleInput()
@@ -177,7 +249,7 @@ public:
 		while (this->game->window.pollEvent(event)) {
 			switch (event.type) {
 				case sf::Event::Closed:
-					this->game->window.close();
+					this->game->quit();
 
 					break;
 
@@ -189,7 +261,7 @@ public:
 
 				case sf::Event::KeyPressed:
 					if (event.key.code == sf::Keyboard::Escape) {
-						this->game->window.close();
+						this->game->quit();
 					}
 
 					mPlayerSystem->handleKeyDown(event.key.code);
@@ -211,15 +283,130 @@ public:
 private:
 	void loadTextures();
 
+	void drawTo(render::Target &target)
+	{
+		mPlayerSystem->followCamera(&this->mGameView, mInterpolation);
+		target.setView(this->mGameView);
+
+		sf::Vector2f viewportSize = this->mGameView.getSize();
+		sf::Vector2f viewportTopLeft = this->mGameView.getCenter() - viewportSize / 2.f;
+		sf::Rect<float> viewport(viewportTopLeft, viewportSize);
+
+		// Large maps only keep the chunks around the view resident.
+		this->map.setStreamingView(viewport);
+
+		// Updating the render system draws it.
+		// We pass the map so we can draw/sort the map as well.
+		mRenderSystem->draw(&this->map, target, viewport, mInterpolation);
+	}
+
+	void pollLoader()
+	{
+		// Takes over the map once prepareFrame finished it, on the simulation thread
+
+		if (mLoaded || !mMapReady) {
+			return;
+		}
+
+		this->map = std::move(mLoadedMap);
+
+		mPlayerSystem->initSpawns();
+		dbg::printMessage("Initialized spawns.", dbg::Urgency::DEFAULT);
+
+		mLoaded = true;
+	}
+
+	void drawLoading(render::Target &target)
+	{
+		// A progress bar in the middle of the window
+
+		sf::Vector2f size(this->game->window.getSize());
+		target.setView(sf::View(sf::FloatRect(0.f, 0.f, size.x, size.y)));
+
+		float progress = mMapLoader.getProgress(mMapHandle);
+		sf::FloatRect bar(size.x * 0.25f, size.y * 0.5f - 8.f, size.x * 0.5f, 16.f);
+		sf::FloatRect filled(bar.left, bar.top, bar.width * progress, bar.height);
+
+		std::vector<sf::Vertex> vertices;
+		render::appendQuad(vertices, render::Item{
+						 .depth = 0.f,
+						 .bounds = bar,
+						 .textureRect = sf::IntRect(),
+						 .texture = nullptr,
+						 .color = sf::Color(64, 64, 64),
+					     });
+		render::appendQuad(vertices, render::Item{
+						 .depth = 0.f,
+						 .bounds = filled,
+						 .textureRect = sf::IntRect(),
+						 .texture = nullptr,
+						 .color = sf::Color::White,
+					     });
+
+		target.draw(vertices.data(), vertices.size(), sf::Quads);
+	}
+
+	unsigned int countTextureBinds(tmx::Map &loadedMap)
+	{
+		// Records the map in the starting view, nothing reaches the window.
+		render::RecordingTarget target;
+		sf::Rect<float> view(mGameView.getCenter() - mGameView.getSize() / 2.f,
+				     mGameView.getSize());
+
+		loadedMap.drawRegion(target, view);
+		return target.getStats().textureBinds;
+	}
+
+	void loadAtlas(tmx::Map &loadedMap, const std::vector<sf::Image> &images)
+	{
+		// Reuse the cached atlas unless a tileset image changed or is missing from it.
+		bool cached = mAtlas.loadFromFile("resources/cache/atlas");
+
+		for (const tmx::Tileset &tileset : loadedMap.tilesets) {
+			cached = cached && mAtlas.find(tileset.imagePath) != nullptr;
+		}
+
+		if (!cached) {
+			mAtlas = TextureAtlas();
+
+			// The loader already decoded the tileset images.
+			for (std::size_t i = 0; i < loadedMap.tilesets.size(); i++) {
+				mAtlas.addImage(loadedMap.tilesets[i].imagePath, images[i]);
+				mAtlas.addSource(loadedMap.tilesets[i].imagePath);
+			}
+
+			mAtlas.pack();
+
+			if (!mAtlas.saveToFile("resources/cache/atlas")) {
+				dbg::printMessage("Unable to cache the texture atlas.",
+						  dbg::Urgency::WARNING);
+			}
+		}
+
+		loadedMap.useAtlas(mAtlas);
+	}
+
 private:
 	tmx::Map map;
+	tmx::MapLoader mMapLoader{DEF_LOADER_THREADS};
+	tmx::MapLoader::Handle mMapHandle;
+	bool mLoaded = false;
+
+	// Filled on the thread that draws, handed over once mMapReady is set.
+	tmx::Map mLoadedMap;
+	std::atomic<bool> mMapReady{false};
+
 	TextureManager mTexMgr;
+	TextureAtlas mAtlas;
 
 	ecs::Coordinator mCoordinator;
 	std::shared_ptr<RenderSystem> mRenderSystem;
 	std::shared_ptr<PlayerSystem> mPlayerSystem;
 	std::shared_ptr<RigidPhysicsSystem> mRigidPhysicsSystem;
+	std::shared_ptr<Box2DPhysicsSystem> mBox2DPhysicsSystem;
 	std::vector<ecs::Entity> mEntities;
+
+	float mInterpolation = 1.f;
 };
 
 #endif
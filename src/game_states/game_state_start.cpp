@@ -102,7 +102,8 @@ void GameStateStart::draw(const sf::Time deltaTime)
 	this->game->window.clear(sf::Color::Black);
 	this->game->window.setView(this->gameView);
 
-	this->map.draw(this->game->window, deltaTime);
+	render::SfmlTarget target(this->game->window);
+	this->map.draw(target, deltaTime);
 
 	this->entityHandler.draw(this->game->window, deltaTime, viewport);
 	/*
@@ -134,7 +135,7 @@ void GameStateStart::handleInput()
 	while (this->game->window.pollEvent(event)) {
 		switch (event.type) {
 			case sf::Event::Closed: {
-				this->game->window.close();
+				this->game->quit();
 
 				break;
 			}
@@ -148,7 +149,7 @@ void GameStateStart::handleInput()
 
 			case sf::Event::KeyPressed: {
 				if (event.key.code == sf::Keyboard::Escape) {
-					this->game->window.close();
+					this->game->quit();
 				}
 
 				controlledEntity->keyPress(event.key.code);
@@ -1,16 +1,33 @@
 #include "common_functions.hpp"
 #include "game.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+
 #include "game_states/game_ecs_test.hpp"
 #include "game_states/game_state_start.hpp"
 
-int main()
+int main(int argc, char *argv[])
 {
 	Game game;
 	game.selfLocation = get_selfpath();
 	game.selfLocation = game.selfLocation.remove_filename();
 	std::cout << game.selfLocation << std::endl;
 
+	for (int i = 1; i < argc; i++) {
+		std::string arg(argv[i]);
+
+		if (arg == "--threaded-render") {
+			game.threadedRendering = true;
+		} else if (arg.rfind("--tick-rate=", 0) == 0) {
+			game.tickRate = std::max(1, std::atoi(arg.c_str() + 12));
+		} else if (arg.rfind("--physics-threads=", 0) == 0) {
+			game.physicsThreads = std::max(1, std::atoi(arg.c_str() + 18));
+		} else if (arg == "--physics=box2d") {
+			game.box2dPhysics = true;
+		}
+	}
+
 	// game.pushState(new GameStateStart(&game));
 	game.pushState(new GameEcsTest(&game));
 	game.gameLoop();
@@ -16,9 +16,19 @@ ParticleSystem::~ParticleSystem()
 
 void ParticleSystem::draw(sf::RenderTarget &target, sf::RenderStates states) const
 {
+	render::SfmlTarget sfmlTarget(target);
+	this->draw(sfmlTarget, states);
+}
+
+void ParticleSystem::draw(render::Target &target, sf::RenderStates states) const
+{
+	this->vertices.clear();
+
 	for (const std::shared_ptr<Particle> &item : this->particles) {
-		target.draw(&item.get()->drawVertex, 1, sf::Points);
+		this->vertices.push_back(item->drawVertex);
 	}
+
+	target.draw(this->vertices.data(), this->vertices.size(), sf::Points, states);
 }
 
 void ParticleSystem::fuel(int particles)
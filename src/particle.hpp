@@ -8,6 +8,8 @@
 #include <sstream>
 #include <vector>
 
+#include "render/target.hpp"
+
 namespace Shape
 {
 enum { CIRCLE, SQUARE };
@@ -95,6 +97,7 @@ public:
 	}
 
 	virtual void draw(sf::RenderTarget &target, sf::RenderStates states) const;
+	void draw(render::Target &target, sf::RenderStates states) const;
 
 	void fuel(int particles);
 	void update(float dt);
@@ -113,6 +116,9 @@ private:
 	sf::Vector2f canvasSize;
 
 	std::vector<std::shared_ptr<Particle>> particles;
+
+	// Scratch buffer so every particle goes out in one draw call.
+	mutable std::vector<sf::Vertex> vertices;
 };
 
 #endif
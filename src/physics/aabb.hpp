@@ -43,7 +43,7 @@ struct Manifold {
 };
 
 // Conversion function
-Object valuesToObject(RigidBody const *rigidBody, Transform const *transform,
+inline Object valuesToObject(RigidBody const *rigidBody, Transform const *transform,
 		      Renderable const *renderable)
 {
 	sf::Rect<float> rect(transform->position, renderable->size);
@@ -61,7 +61,7 @@ Object valuesToObject(RigidBody const *rigidBody, Transform const *transform,
 }
 
 // Vector math functions
-bool AABBvsAABB(AABB a, AABB b)
+inline bool AABBvsAABB(AABB a, AABB b)
 {
 	if (a.max.x < b.min.x || a.min.x > b.max.x) {
 		return false;
@@ -74,12 +74,12 @@ bool AABBvsAABB(AABB a, AABB b)
 	return true;
 }
 
-float clamp(float value, float min, float max)
+inline float clamp(float value, float min, float max)
 {
 	return std::max(min, std::min(max, value));
 }
 
-sf::Vector2f clamp(sf::Vector2f value, sf::Vector2f min, sf::Vector2f max)
+inline sf::Vector2f clamp(sf::Vector2f value, sf::Vector2f min, sf::Vector2f max)
 {
 	float clampX = std::max(min.x, std::min(max.x, value.x));
 	float clampY = std::max(min.y, std::min(max.y, value.y));
@@ -87,7 +87,7 @@ sf::Vector2f clamp(sf::Vector2f value, sf::Vector2f min, sf::Vector2f max)
 	return sf::Vector2f(clampX, clampY);
 }
 
-float vecLength(sf::Vector2f value)
+inline float vecLength(sf::Vector2f value)
 {
 	float x = std::pow(value.x, 2);
 	float y = std::pow(value.y, 2);
@@ -95,19 +95,19 @@ float vecLength(sf::Vector2f value)
 	return std::sqrt(x + y);
 }
 
-float vecDot(sf::Vector2f one, sf::Vector2f two)
+inline float vecDot(sf::Vector2f one, sf::Vector2f two)
 {
 	return one.x * two.x + one.y * two.y;
 }
 
-sf::Vector2f vecNormalize(sf::Vector2f v)
+inline sf::Vector2f vecNormalize(sf::Vector2f v)
 {
 	float len = vecLength(v);
 
 	return sf::Vector2f(v.x / len, v.y / len);
 }
 
-Direction vectorDirection(sf::Vector2f target)
+inline Direction vectorDirection(sf::Vector2f target)
 {
 	sf::Vector2f compass[] = {
 	    sf::Vector2f(0.0f, 1.0f),  // Up
@@ -132,7 +132,7 @@ Direction vectorDirection(sf::Vector2f target)
 }
 
 // Collision functions
-bool AABBvsAABB(Manifold *m)
+inline bool AABBvsAABB(Manifold *m)
 {
 	Object *A = m->A;
 	Object *B = m->B;
@@ -179,7 +179,7 @@ bool AABBvsAABB(Manifold *m)
 	return false;
 }
 
-Direction collDirCheck(Manifold *m)
+inline Direction collDirCheck(Manifold *m)
 {
 	Object *A = m->A;
 	Object *B = m->B;
@@ -201,13 +201,90 @@ Direction collDirCheck(Manifold *m)
 	return Direction::NOCOLL;
 }
 
-sf::Rect<float> basicCollCheck(Manifold *m)
+inline sf::Rect<float> basicCollCheck(Manifold *m)
 {
 	sf::Rect<float> intersection;
 	m->A->rect.intersects(m->B->rect, intersection);
 
 	return intersection;
 }
+
+/* Touching or overlapping boxes, with the normal pointing from b towards a along the axis
+ * of least overlap. Boxes meeting only at a corner don't count. */
+inline bool contactAABB(const AABB &a, const AABB &b, sf::Vector2f &normal, float &penetration)
+{
+	float overlapX = std::min(a.max.x, b.max.x) - std::max(a.min.x, b.min.x);
+	float overlapY = std::min(a.max.y, b.max.y) - std::max(a.min.y, b.min.y);
+
+	if (overlapX < 0.f || overlapY < 0.f || (overlapX == 0.f && overlapY == 0.f)) {
+		return false;
+	}
+
+	if (overlapX < overlapY) {
+		normal = sf::Vector2f(a.min.x + a.max.x < b.min.x + b.max.x ? -1.f : 1.f, 0.f);
+		penetration = overlapX;
+	} else {
+		normal = sf::Vector2f(0.f, a.min.y + a.max.y < b.min.y + b.max.y ? -1.f : 1.f);
+		penetration = overlapY;
+	}
+
+	return true;
+}
+
+/* Swept test of a box moving by displacement against a still one. On a hit toi is the
+ * fraction of the move made before touching and normal points away from the still box.
+ * Boxes already overlapping at the start don't count, so bodies can always separate. */
+inline bool sweptAABB(const AABB &moving, sf::Vector2f displacement, const AABB &still,
+		      float &toi, sf::Vector2f &normal)
+{
+	const float inf = std::numeric_limits<float>::infinity();
+
+	float entryX = -inf;
+	float exitX = inf;
+	float entryY = -inf;
+	float exitY = inf;
+
+	if (displacement.x == 0.f) {
+		if (moving.max.x <= still.min.x || moving.min.x >= still.max.x) {
+			return false;
+		}
+	} else if (displacement.x > 0.f) {
+		entryX = (still.min.x - moving.max.x) / displacement.x;
+		exitX = (still.max.x - moving.min.x) / displacement.x;
+	} else {
+		entryX = (still.max.x - moving.min.x) / displacement.x;
+		exitX = (still.min.x - moving.max.x) / displacement.x;
+	}
+
+	if (displacement.y == 0.f) {
+		if (moving.max.y <= still.min.y || moving.min.y >= still.max.y) {
+			return false;
+		}
+	} else if (displacement.y > 0.f) {
+		entryY = (still.min.y - moving.max.y) / displacement.y;
+		exitY = (still.max.y - moving.min.y) / displacement.y;
+	} else {
+		entryY = (still.max.y - moving.min.y) / displacement.y;
+		exitY = (still.min.y - moving.max.y) / displacement.y;
+	}
+
+	float entry = std::max(entryX, entryY);
+	float exit = std::min(exitX, exitY);
+
+	if (entry >= exit || entry < 0.f || entry >= 1.f) {
+		return false;
+	}
+
+	toi = entry;
+
+	if (entryX > entryY) {
+		normal = sf::Vector2f(displacement.x > 0.f ? -1.f : 1.f, 0.f);
+	} else {
+		normal = sf::Vector2f(0.f, displacement.y > 0.f ? -1.f : 1.f);
+	}
+
+	return true;
+}
 } // namespace physics
 
 #endif
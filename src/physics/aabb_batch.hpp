@@ -0,0 +1,159 @@
+#ifndef PHYSICS_AABB_BATCH_HPP
+#define PHYSICS_AABB_BATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define PHYSICS_AABB_BATCH_X86
+#endif
+
+#include "aabb.hpp"
+
+namespace physics
+{
+/* Boxes stored as separate min and max columns, so one box can be tested against 4 (SSE2) or
+ * 8 (AVX2) others with a handful of instructions. */
+struct AABBBatch {
+	std::vector<float> minX;
+	std::vector<float> minY;
+	std::vector<float> maxX;
+	std::vector<float> maxY;
+
+	void clear()
+	{
+		minX.clear();
+		minY.clear();
+		maxX.clear();
+		maxY.clear();
+	}
+
+	void push(const AABB &box)
+	{
+		minX.push_back(box.min.x);
+		minY.push_back(box.min.y);
+		maxX.push_back(box.max.x);
+		maxY.push_back(box.max.y);
+	}
+
+	std::size_t size() const
+	{
+		return minX.size();
+	}
+};
+
+// Appends the index of every box in [first, first + count) overlapping box, in order.
+using OverlapKernel = void (*)(const AABBBatch &batch, std::size_t first, std::size_t count,
+			       const AABB &box, std::vector<std::uint32_t> &hits);
+
+namespace detail
+{
+// Same rule as AABBvsAABB, touching edges overlap.
+inline void overlapScalar(const AABBBatch &batch, std::size_t first, std::size_t count,
+			  const AABB &box, std::vector<std::uint32_t> &hits)
+{
+	for (std::size_t i = first; i < first + count; i++) {
+		if (batch.minX[i] <= box.max.x && batch.maxX[i] >= box.min.x &&
+		    batch.minY[i] <= box.max.y && batch.maxY[i] >= box.min.y) {
+			hits.push_back(static_cast<std::uint32_t>(i));
+		}
+	}
+}
+
+#ifdef PHYSICS_AABB_BATCH_X86
+// Turns a lane mask into indices, lowest lane first.
+inline void appendMask(unsigned int mask, std::size_t base, std::vector<std::uint32_t> &hits)
+{
+	while (mask != 0) {
+		hits.push_back(static_cast<std::uint32_t>(base + __builtin_ctz(mask)));
+		mask &= mask - 1;
+	}
+}
+
+__attribute__((target("sse2"))) inline void
+overlapSSE2(const AABBBatch &batch, std::size_t first, std::size_t count, const AABB &box,
+	    std::vector<std::uint32_t> &hits)
+{
+	const __m128 boxMinX = _mm_set1_ps(box.min.x);
+	const __m128 boxMinY = _mm_set1_ps(box.min.y);
+	const __m128 boxMaxX = _mm_set1_ps(box.max.x);
+	const __m128 boxMaxY = _mm_set1_ps(box.max.y);
+
+	std::size_t end = first + count;
+	std::size_t i = first;
+
+	for (; i + 4 <= end; i += 4) {
+		__m128 x = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&batch.minX[i]), boxMaxX),
+				      _mm_cmpge_ps(_mm_loadu_ps(&batch.maxX[i]), boxMinX));
+		__m128 y = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&batch.minY[i]), boxMaxY),
+				      _mm_cmpge_ps(_mm_loadu_ps(&batch.maxY[i]), boxMinY));
+
+		appendMask(static_cast<unsigned int>(_mm_movemask_ps(_mm_and_ps(x, y))), i, hits);
+	}
+
+	overlapScalar(batch, i, end - i, box, hits);
+}
+
+__attribute__((target("avx2"))) inline void
+overlapAVX2(const AABBBatch &batch, std::size_t first, std::size_t count, const AABB &box,
+	    std::vector<std::uint32_t> &hits)
+{
+	const __m256 boxMinX = _mm256_set1_ps(box.min.x);
+	const __m256 boxMinY = _mm256_set1_ps(box.min.y);
+	const __m256 boxMaxX = _mm256_set1_ps(box.max.x);
+	const __m256 boxMaxY = _mm256_set1_ps(box.max.y);
+
+	std::size_t end = first + count;
+	std::size_t i = first;
+
+	for (; i + 8 <= end; i += 8) {
+		__m256 x = _mm256_and_ps(
+		    _mm256_cmp_ps(_mm256_loadu_ps(&batch.minX[i]), boxMaxX, _CMP_LE_OQ),
+		    _mm256_cmp_ps(_mm256_loadu_ps(&batch.maxX[i]), boxMinX, _CMP_GE_OQ));
+		__m256 y = _mm256_and_ps(
+		    _mm256_cmp_ps(_mm256_loadu_ps(&batch.minY[i]), boxMaxY, _CMP_LE_OQ),
+		    _mm256_cmp_ps(_mm256_loadu_ps(&batch.maxY[i]), boxMinY, _CMP_GE_OQ));
+
+		appendMask(static_cast<unsigned int>(_mm256_movemask_ps(_mm256_and_ps(x, y))), i,
+			   hits);
+	}
+
+	overlapSSE2(batch, i, end - i, box, hits);
+}
+#endif
+
+inline OverlapKernel pickOverlapKernel()
+{
+#ifdef PHYSICS_AABB_BATCH_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2")) {
+		return overlapAVX2;
+	}
+
+	if (__builtin_cpu_supports("sse2")) {
+		return overlapSSE2;
+	}
+#endif
+
+	return overlapScalar;
+}
+} // namespace detail
+
+// Widest kernel the CPU running the game supports, picked once.
+inline OverlapKernel overlapKernel()
+{
+	static const OverlapKernel kernel = detail::pickOverlapKernel();
+	return kernel;
+}
+
+inline void overlapping(const AABBBatch &batch, std::size_t first, std::size_t count,
+			const AABB &box, std::vector<std::uint32_t> &hits)
+{
+	overlapKernel()(batch, first, count, box, hits);
+}
+} // namespace physics
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef PHYSICS_AABB_TREE_HPP
+#define PHYSICS_AABB_TREE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "aabb.hpp"
+#include "aabb_batch.hpp"
+
+namespace physics
+{
+/* Bounding volume tree over boxes that never move, built once top down by splitting the
+ * longest axis at the median. Nodes live in one flat vector so a query is a plain loop. */
+class StaticAABBTree
+{
+public:
+	void build(const std::vector<AABB> &boxes)
+	{
+		mNodes.clear();
+		mBoxes = boxes;
+		mIndices.resize(boxes.size());
+		std::iota(mIndices.begin(), mIndices.end(), 0);
+
+		if (!boxes.empty()) {
+			mNodes.reserve(boxes.size() * 2 / LEAF_SIZE + 1);
+			mNodes.push_back(Node{});
+			buildNode(0, 0, static_cast<std::uint32_t>(boxes.size()));
+		}
+
+		// Leaves are contiguous runs of mIndices, so store the boxes in that order.
+		mLeafBoxes.clear();
+		for (std::uint32_t index : mIndices) {
+			mLeafBoxes.push(mBoxes[index]);
+		}
+	}
+
+	// Index of every box overlapping the given one, touching edges included.
+	void query(const AABB &box, std::vector<std::uint32_t> &results) const
+	{
+		if (mNodes.empty()) {
+			return;
+		}
+
+		std::uint32_t stack[64];
+		int top = 0;
+		stack[top++] = 0;
+
+		while (top > 0) {
+			const Node &node = mNodes[stack[--top]];
+
+			if (!AABBvsAABB(node.box, box)) {
+				continue;
+			}
+
+			if (node.count > 0) {
+				// The kernel reports leaf slots, swap them for the box indices.
+				std::size_t firstHit = results.size();
+				overlapping(mLeafBoxes, node.first, node.count, box, results);
+
+				for (std::size_t i = firstHit; i < results.size(); i++) {
+					results[i] = mIndices[results[i]];
+				}
+
+				continue;
+			}
+
+			stack[top++] = node.first;
+			stack[top++] = node.first + 1;
+		}
+	}
+
+	const AABB &getBox(std::uint32_t index) const
+	{
+		return mBoxes[index];
+	}
+
+	std::size_t size() const
+	{
+		return mBoxes.size();
+	}
+
+	std::size_t getNodeCount() const
+	{
+		return mNodes.size();
+	}
+
+private:
+	// Fills one AVX2 test.
+	static constexpr std::uint32_t LEAF_SIZE = 8;
+
+	// Leaves have count > 0 and first is into mIndices, inner nodes have count 0 and first
+	// is the left child, the right child always follows it.
+	struct Node {
+		AABB box;
+		std::uint32_t first;
+		std::uint32_t count;
+	};
+
+	void buildNode(std::uint32_t nodeIndex, std::uint32_t first, std::uint32_t count)
+	{
+		AABB bounds = mBoxes[mIndices[first]];
+		for (std::uint32_t i = first + 1; i < first + count; i++) {
+			const AABB &box = mBoxes[mIndices[i]];
+			bounds.min.x = std::min(bounds.min.x, box.min.x);
+			bounds.min.y = std::min(bounds.min.y, box.min.y);
+			bounds.max.x = std::max(bounds.max.x, box.max.x);
+			bounds.max.y = std::max(bounds.max.y, box.max.y);
+		}
+
+		mNodes[nodeIndex] = Node{bounds, first, count};
+
+		if (count <= LEAF_SIZE) {
+			return;
+		}
+
+		// Split the longest axis at the median centre.
+		bool splitX = bounds.max.x - bounds.min.x >= bounds.max.y - bounds.min.y;
+		std::uint32_t half = count / 2;
+
+		std::nth_element(mIndices.begin() + first, mIndices.begin() + first + half,
+				 mIndices.begin() + first + count,
+				 [this, splitX](std::uint32_t lhs, std::uint32_t rhs) {
+					 const AABB &a = mBoxes[lhs];
+					 const AABB &b = mBoxes[rhs];
+
+					 if (splitX) {
+						 return a.min.x + a.max.x < b.min.x + b.max.x;
+					 }
+
+					 return a.min.y + a.max.y < b.min.y + b.max.y;
+				 });
+
+		// Children are allocated as a pair so the right one is always left + 1.
+		std::uint32_t left = static_cast<std::uint32_t>(mNodes.size());
+		mNodes.push_back(Node{});
+		mNodes.push_back(Node{});
+
+		mNodes[nodeIndex].first = left;
+		mNodes[nodeIndex].count = 0;
+
+		buildNode(left, first, half);
+		buildNode(left + 1, first + half, count - half);
+	}
+
+	std::vector<Node> mNodes;
+	std::vector<AABB> mBoxes;
+	std::vector<std::uint32_t> mIndices;
+	AABBBatch mLeafBoxes;
+};
+} // namespace physics
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef PHYSICS_BROADPHASE_HPP
+#define PHYSICS_BROADPHASE_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "aabb.hpp"
+
+#include "../components/collision_filter.hpp"
+
+namespace physics
+{
+// Two proxies whose boxes overlap, always ordered so a < b.
+struct Pair {
+	std::uint32_t a;
+	std::uint32_t b;
+
+	bool operator<(const Pair &rhs) const
+	{
+		return a == rhs.a ? b < rhs.b : a < rhs.a;
+	}
+};
+
+/* Finds which bodies might touch so the narrowphase only runs on those. Proxies are keyed by
+ * an id chosen by the caller (the entity) and are kept up to date incrementally. Proxies whose
+ * filters reject each other are never reported together. */
+class Broadphase
+{
+public:
+	virtual ~Broadphase() = default;
+
+	virtual void insert(std::uint32_t id, const AABB &box, const CollisionFilter &filter) = 0;
+	virtual void update(std::uint32_t id, const AABB &box, const CollisionFilter &filter) = 0;
+	virtual void remove(std::uint32_t id) = 0;
+	virtual bool contains(std::uint32_t id) const = 0;
+
+	// Every proxy overlapping the box and accepted by the filter once, in no particular order.
+	// Safe to call from several threads at once as long as nothing is inserted or moved.
+	virtual void query(const AABB &box, const CollisionFilter &filter,
+			   std::vector<std::uint32_t> &results) const = 0;
+};
+} // namespace physics
+
+#endif
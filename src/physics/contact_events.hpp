@@ -0,0 +1,96 @@
+#ifndef PHYSICS_CONTACT_EVENTS_HPP
+#define PHYSICS_CONTACT_EVENTS_HPP
+
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace physics
+{
+// Stands in for the map's blocking tiles as the second body of a contact.
+const std::uint32_t STATIC_BODY = 0xFFFFFFFF;
+
+struct ContactEvent {
+	enum Type {
+		BEGIN,
+		STAY,
+		END,
+	};
+
+	Type type;
+
+	// a < b, unless b is STATIC_BODY.
+	std::uint32_t a;
+	std::uint32_t b;
+
+	// Points from b towards a, the way a would have to move to separate.
+	sf::Vector2f normal;
+	// Overlap along the normal, 0 for boxes that are only touching.
+	float penetration;
+};
+
+/* Fixed size ring of the contact events from the last physics tick. Physics clears and fills
+ * it, gameplay reads it afterwards. When more events happen than fit the oldest are dropped
+ * and counted. */
+class ContactEventBuffer
+{
+public:
+	explicit ContactEventBuffer(std::size_t capacity = 1024) : mEvents(capacity)
+	{
+	}
+
+	void clear()
+	{
+		mFirst = 0;
+		mSize = 0;
+		mDropped = 0;
+	}
+
+	void push(const ContactEvent &event)
+	{
+		if (mEvents.empty()) {
+			mDropped++;
+			return;
+		}
+
+		if (mSize == mEvents.size()) {
+			mFirst = (mFirst + 1) % mEvents.size();
+			mSize--;
+			mDropped++;
+		}
+
+		mEvents[(mFirst + mSize) % mEvents.size()] = event;
+		mSize++;
+	}
+
+	// Oldest first.
+	const ContactEvent &operator[](std::size_t index) const
+	{
+		return mEvents[(mFirst + index) % mEvents.size()];
+	}
+
+	std::size_t size() const
+	{
+		return mSize;
+	}
+
+	bool empty() const
+	{
+		return mSize == 0;
+	}
+
+	std::size_t getDropped() const
+	{
+		return mDropped;
+	}
+
+private:
+	std::vector<ContactEvent> mEvents;
+	std::size_t mFirst = 0;
+	std::size_t mSize = 0;
+	std::size_t mDropped = 0;
+};
+} // namespace physics
+
+#endif
@@ -0,0 +1,302 @@
+#ifndef PHYSICS_QUERIES_HPP
+#define PHYSICS_QUERIES_HPP
+
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "aabb.hpp"
+#include "broadphase.hpp"
+#include "contact_events.hpp"
+
+#include "../components/collision_filter.hpp"
+#include "../tmx-parser/map.hpp"
+
+/* Scene queries against the dynamic bodies in a broadphase and the map's collision layers.
+ * The broadphase only knows fattened boxes, so every query takes a getBox(id) callable that
+ * returns a body's exact box. Filters work as if the ray or shape were a body with them. */
+namespace physics
+{
+struct Ray {
+	sf::Vector2f origin;
+	sf::Vector2f direction; // Any length, only the direction is used.
+	float maxDistance;      // In pixels, infinity for an endless ray.
+
+	CollisionFilter filter = CollisionFilter{};
+	std::uint32_t ignore = STATIC_BODY; // A body to skip, like the one casting the ray.
+};
+
+struct RayHit {
+	bool hit = false;
+	std::uint32_t body = STATIC_BODY; // STATIC_BODY for tiles.
+	float distance = 0.f;
+	sf::Vector2f point;
+	sf::Vector2f normal; // Zero if the ray started inside what it hit.
+};
+
+namespace detail
+{
+// Reused between calls so a batch of rays doesn't allocate.
+inline std::vector<std::uint32_t> &queryScratch()
+{
+	thread_local std::vector<std::uint32_t> scratch;
+	return scratch;
+}
+
+// How far the ray runs before leaving box, which has to contain origin. direction can't be
+// zero.
+inline float exitDistance(sf::Vector2f origin, sf::Vector2f direction, const AABB &box)
+{
+	float distance = std::numeric_limits<float>::max();
+
+	if (direction.x != 0.f) {
+		float edge = direction.x > 0.f ? box.max.x : box.min.x;
+		distance = std::min(distance, (edge - origin.x) / direction.x);
+	}
+
+	if (direction.y != 0.f) {
+		float edge = direction.y > 0.f ? box.max.y : box.min.y;
+		distance = std::min(distance, (edge - origin.y) / direction.y);
+	}
+
+	return distance;
+}
+} // namespace detail
+
+// Slab test, inverse holds 1 / direction per axis (infinite for a zero axis).
+inline bool rayAABB(sf::Vector2f origin, sf::Vector2f inverse, float maxDistance, const AABB &box,
+		    float &distance, sf::Vector2f &normal)
+{
+	float nearX = (box.min.x - origin.x) * inverse.x;
+	float farX = (box.max.x - origin.x) * inverse.x;
+	float nearY = (box.min.y - origin.y) * inverse.y;
+	float farY = (box.max.y - origin.y) * inverse.y;
+
+	// 0 * inf is NaN for a ray lying exactly on an edge, that counts as a miss.
+	if (std::isnan(nearX) || std::isnan(farX) || std::isnan(nearY) || std::isnan(farY)) {
+		return false;
+	}
+
+	if (nearX > farX) {
+		std::swap(nearX, farX);
+	}
+
+	if (nearY > farY) {
+		std::swap(nearY, farY);
+	}
+
+	float entry = std::max(nearX, nearY);
+	float exit = std::min(farX, farY);
+
+	if (entry > exit || exit < 0.f || entry > maxDistance) {
+		return false;
+	}
+
+	if (entry <= 0.f) {
+		distance = 0.f;
+		normal = sf::Vector2f(0.f, 0.f);
+	} else if (nearX > nearY) {
+		distance = entry;
+		normal = sf::Vector2f(inverse.x > 0.f ? -1.f : 1.f, 0.f);
+	} else {
+		distance = entry;
+		normal = sf::Vector2f(0.f, inverse.y > 0.f ? -1.f : 1.f);
+	}
+
+	return true;
+}
+
+// Circle against box, touching counts.
+inline bool circleAABB(sf::Vector2f center, float radius, const AABB &box)
+{
+	sf::Vector2f closest = clamp(center, box.min, box.max) - center;
+	return vecDot(closest, closest) <= radius * radius;
+}
+
+// First tile or body along the ray. Tiles are walked first so the body query only covers
+// the part of the ray in front of the nearest wall. Ties go to tiles, then the lower id.
+template <typename GetBox>
+bool raycast(const Broadphase &bodies, GetBox &&getBox, const tmx::Map &map, const Ray &ray,
+	     RayHit &hit)
+{
+	hit = RayHit{};
+
+	float length = vecLength(ray.direction);
+	if (length == 0.f || !(ray.maxDistance >= 0.f)) {
+		return false;
+	}
+
+	sf::Vector2f direction = ray.direction / length;
+	float maxDistance = ray.maxDistance;
+
+	for (auto const &collision : map.collisionLayers) {
+		float distance;
+		sf::Vector2f normal;
+
+		if ((collision.category & ray.filter.mask) == 0 ||
+		    !collision.raycast(ray.origin, direction, maxDistance, distance, normal)) {
+			continue;
+		}
+
+		if (!hit.hit || distance < hit.distance) {
+			hit.hit = true;
+			hit.distance = distance;
+			hit.normal = normal;
+			maxDistance = distance;
+		}
+	}
+
+	const float inf = std::numeric_limits<float>::infinity();
+	sf::Vector2f inverse(direction.x != 0.f ? 1.f / direction.x : inf,
+			     direction.y != 0.f ? 1.f / direction.y : inf);
+
+	// The broadphase needs a finite box, an endless ray that missed the tiles looks for
+	// bodies up to the map's edge, or as far as the origin when it starts outside the map.
+	float reach = maxDistance;
+
+	if (!std::isfinite(reach)) {
+		sf::Vector2f mapSize(static_cast<float>(map.width * map.tileWidth),
+				     static_cast<float>(map.height * map.tileHeight));
+		AABB world{.min = sf::Vector2f(std::min(ray.origin.x, 0.f),
+					       std::min(ray.origin.y, 0.f)),
+			   .max = sf::Vector2f(std::max(ray.origin.x, mapSize.x),
+					       std::max(ray.origin.y, mapSize.y))};
+
+		reach = detail::exitDistance(ray.origin, direction, world);
+	}
+
+	sf::Vector2f end = ray.origin + direction * reach;
+	AABB segment{.min = sf::Vector2f(std::min(ray.origin.x, end.x),
+					 std::min(ray.origin.y, end.y)),
+		     .max = sf::Vector2f(std::max(ray.origin.x, end.x),
+					 std::max(ray.origin.y, end.y))};
+
+	std::vector<std::uint32_t> &candidates = detail::queryScratch();
+	candidates.clear();
+	bodies.query(segment, ray.filter, candidates);
+
+	for (std::uint32_t body : candidates) {
+		float distance;
+		sf::Vector2f normal;
+
+		if (body == ray.ignore ||
+		    !rayAABB(ray.origin, inverse, maxDistance, getBox(body), distance, normal)) {
+			continue;
+		}
+
+		if (!hit.hit || distance < hit.distance ||
+		    (distance == hit.distance && hit.body != STATIC_BODY && body < hit.body)) {
+			hit.hit = true;
+			hit.body = body;
+			hit.distance = distance;
+			hit.normal = normal;
+		}
+	}
+
+	hit.point = ray.origin + direction * hit.distance;
+	return hit.hit;
+}
+
+// Many rays in one call, for things like line of sight checks. hits[i] is the result of
+// rays[i].
+template <typename GetBox>
+void raycast(const Broadphase &bodies, GetBox &&getBox, const tmx::Map &map,
+	     const std::vector<Ray> &rays, std::vector<RayHit> &hits)
+{
+	hits.resize(rays.size());
+
+	for (std::size_t i = 0; i < rays.size(); i++) {
+		raycast(bodies, getBox, map, rays[i], hits[i]);
+	}
+}
+
+namespace detail
+{
+// True if any blocking tile the filter collides with passes test(box of a merged rect).
+template <typename Test>
+bool overlapsTiles(const tmx::Map &map, const AABB &bounds, const CollisionFilter &filter,
+		   Test &&test)
+{
+	thread_local std::vector<AABB> boxes;
+
+	for (auto const &collision : map.collisionLayers) {
+		if ((collision.category & filter.mask) == 0) {
+			continue;
+		}
+
+		boxes.clear();
+		collision.query(sf::Rect<float>(bounds.min, bounds.max - bounds.min), boxes);
+
+		for (const AABB &box : boxes) {
+			if (test(box)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+} // namespace detail
+
+// Bodies overlapping the box, touching counts, sorted by id. Blocking tiles show up once as
+// STATIC_BODY, which sorts last. Replaces results.
+template <typename GetBox>
+void queryAABB(const Broadphase &bodies, GetBox &&getBox, const tmx::Map &map, const AABB &box,
+	       const CollisionFilter &filter, std::vector<std::uint32_t> &results)
+{
+	results.clear();
+
+	std::vector<std::uint32_t> &candidates = detail::queryScratch();
+	candidates.clear();
+	bodies.query(box, filter, candidates);
+
+	for (std::uint32_t body : candidates) {
+		if (AABBvsAABB(box, getBox(body))) {
+			results.push_back(body);
+		}
+	}
+
+	std::sort(results.begin(), results.end());
+
+	if (detail::overlapsTiles(map, box, filter,
+				  [&box](const AABB &tile) { return AABBvsAABB(box, tile); })) {
+		results.push_back(STATIC_BODY);
+	}
+}
+
+// Bodies overlapping the circle, touching counts, sorted by id. Blocking tiles show up once as
+// STATIC_BODY, which sorts last. Replaces results.
+template <typename GetBox>
+void queryCircle(const Broadphase &bodies, GetBox &&getBox, const tmx::Map &map,
+		 sf::Vector2f center, float radius, const CollisionFilter &filter,
+		 std::vector<std::uint32_t> &results)
+{
+	results.clear();
+
+	AABB bounds{.min = center - sf::Vector2f(radius, radius),
+		    .max = center + sf::Vector2f(radius, radius)};
+
+	std::vector<std::uint32_t> &candidates = detail::queryScratch();
+	candidates.clear();
+	bodies.query(bounds, filter, candidates);
+
+	for (std::uint32_t body : candidates) {
+		if (circleAABB(center, radius, getBox(body))) {
+			results.push_back(body);
+		}
+	}
+
+	std::sort(results.begin(), results.end());
+
+	if (detail::overlapsTiles(map, bounds, filter, [center, radius](const AABB &tile) {
+		    return circleAABB(center, radius, tile);
+	    })) {
+		results.push_back(STATIC_BODY);
+	}
+}
+} // namespace physics
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef PHYSICS_SPATIAL_HASH_GRID_HPP
+#define PHYSICS_SPATIAL_HASH_GRID_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "aabb.hpp"
+#include "aabb_batch.hpp"
+#include "broadphase.hpp"
+
+namespace physics
+{
+/* Uniform grid hashed by cell coordinate. A proxy is listed in every cell its box touches,
+ * so only proxies sharing a cell are ever compared. Cell size should be around the size of
+ * a typical body. */
+class SpatialHashGrid : public Broadphase
+{
+public:
+	explicit SpatialHashGrid(float cellSize = 64.f) : mCellSize(cellSize)
+	{
+	}
+
+	void insert(std::uint32_t id, const AABB &box, const CollisionFilter &filter) override
+	{
+		if (id >= mProxies.size()) {
+			mProxies.resize(id + 1);
+		}
+
+		Proxy &proxy = mProxies[id];
+		proxy.box = box;
+		proxy.filter = filter;
+		proxy.active = true;
+		toCells(box, proxy.minX, proxy.minY, proxy.maxX, proxy.maxY);
+
+		addToCells(id, proxy);
+	}
+
+	void update(std::uint32_t id, const AABB &box, const CollisionFilter &filter) override
+	{
+		if (!contains(id)) {
+			insert(id, box, filter);
+			return;
+		}
+
+		Proxy &proxy = mProxies[id];
+		proxy.box = box;
+		proxy.filter = filter;
+
+		int minX, minY, maxX, maxY;
+		toCells(box, minX, minY, maxX, maxY);
+
+		// Most moves stay inside the same cells, then only the box changes.
+		if (minX == proxy.minX && minY == proxy.minY && maxX == proxy.maxX &&
+		    maxY == proxy.maxY) {
+			return;
+		}
+
+		removeFromCells(id, proxy);
+		proxy.minX = minX;
+		proxy.minY = minY;
+		proxy.maxX = maxX;
+		proxy.maxY = maxY;
+		addToCells(id, proxy);
+	}
+
+	void remove(std::uint32_t id) override
+	{
+		if (!contains(id)) {
+			return;
+		}
+
+		removeFromCells(id, mProxies[id]);
+		mProxies[id].active = false;
+	}
+
+	bool contains(std::uint32_t id) const override
+	{
+		return id < mProxies.size() && mProxies[id].active;
+	}
+
+	void query(const AABB &box, const CollisionFilter &filter,
+		   std::vector<std::uint32_t> &results) const override
+	{
+		// Scratch per thread, queries only read the grid so they can run concurrently.
+		thread_local AABBBatch candidateBoxes;
+		thread_local std::vector<std::uint32_t> candidateIds;
+
+		int minX, minY, maxX, maxY;
+		toCells(box, minX, minY, maxX, maxY);
+
+		candidateIds.clear();
+		candidateBoxes.clear();
+
+		for (int y = minY; y <= maxY; y++) {
+			for (int x = minX; x <= maxX; x++) {
+				auto cell = mCells.find(key(x, y));
+
+				if (cell == mCells.end()) {
+					continue;
+				}
+
+				for (std::uint32_t id : cell->second) {
+					const Proxy &proxy = mProxies[id];
+
+					// A proxy spanning several cells is only gathered by the
+					// first cell it shares with the query.
+					if (x != std::max(proxy.minX, minX) ||
+					    y != std::max(proxy.minY, minY)) {
+						continue;
+					}
+
+					// Rejected by filter before any box is looked at.
+					if (!shouldCollide(proxy.filter, filter)) {
+						continue;
+					}
+
+					candidateIds.push_back(id);
+					candidateBoxes.push(proxy.box);
+				}
+			}
+		}
+
+		// Then test everything gathered in one batch.
+		std::size_t firstHit = results.size();
+		overlapping(candidateBoxes, 0, candidateBoxes.size(), box, results);
+
+		for (std::size_t i = firstHit; i < results.size(); i++) {
+			results[i] = candidateIds[results[i]];
+		}
+	}
+
+	const AABB &getBox(std::uint32_t id) const
+	{
+		return mProxies[id].box;
+	}
+
+	float getCellSize() const
+	{
+		return mCellSize;
+	}
+
+private:
+	struct Proxy {
+		AABB box;
+		CollisionFilter filter;
+		int minX = 0;
+		int minY = 0;
+		int maxX = 0;
+		int maxY = 0;
+		bool active = false;
+	};
+
+	static std::uint64_t key(int x, int y)
+	{
+		return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) |
+		       static_cast<std::uint32_t>(y);
+	}
+
+	void toCells(const AABB &box, int &minX, int &minY, int &maxX, int &maxY) const
+	{
+		minX = static_cast<int>(std::floor(box.min.x / mCellSize));
+		minY = static_cast<int>(std::floor(box.min.y / mCellSize));
+		maxX = static_cast<int>(std::floor(box.max.x / mCellSize));
+		maxY = static_cast<int>(std::floor(box.max.y / mCellSize));
+	}
+
+	void addToCells(std::uint32_t id, const Proxy &proxy)
+	{
+		for (int y = proxy.minY; y <= proxy.maxY; y++) {
+			for (int x = proxy.minX; x <= proxy.maxX; x++) {
+				mCells[key(x, y)].push_back(id);
+			}
+		}
+	}
+
+	void removeFromCells(std::uint32_t id, const Proxy &proxy)
+	{
+		for (int y = proxy.minY; y <= proxy.maxY; y++) {
+			for (int x = proxy.minX; x <= proxy.maxX; x++) {
+				auto cell = mCells.find(key(x, y));
+
+				if (cell == mCells.end()) {
+					continue;
+				}
+
+				std::vector<std::uint32_t> &ids = cell->second;
+				auto it = std::find(ids.begin(), ids.end(), id);
+
+				if (it != ids.end()) {
+					*it = ids.back();
+					ids.pop_back();
+				}
+
+				if (ids.empty()) {
+					mCells.erase(cell);
+				}
+			}
+		}
+	}
+
+	float mCellSize;
+
+	std::vector<Proxy> mProxies; // Indexed by id
+	std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> mCells;
+};
+} // namespace physics
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef RENDER_RENDER_ITEM_HPP
+#define RENDER_RENDER_ITEM_HPP
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace render
+{
+// Tiled's flip bits, the top three bits of a gid shifted down.
+enum Flip : std::uint8_t {
+	FLIP_DIAGONAL = 1,
+	FLIP_VERTICAL = 2,
+	FLIP_HORIZONTAL = 4,
+};
+
+/* A single textured (or flat coloured) quad that takes part in the depth sort.
+ * Entities and overlay tiles both become items so they can be ordered together. */
+struct Item {
+	// Y coordinate of the bottom edge, lower values are drawn first.
+	float depth;
+
+	sf::FloatRect bounds;
+	sf::IntRect textureRect;
+	const sf::Texture *texture; // nullptr draws a flat coloured quad.
+	sf::Color color;
+	std::uint8_t flips = 0; // Flip bits, applied to the texture rect.
+};
+
+struct ItemComparator {
+	bool operator()(const Item &item1, const Item &item2) const
+	{
+		if (item1.depth == item2.depth) {
+			return item1.bounds.left < item2.bounds.left;
+		}
+
+		return item1.depth < item2.depth;
+	}
+};
+
+// Swap a quad's texture coordinates around to flip it. Tiled flips diagonally first, then
+// horizontally, then vertically.
+inline void flipQuad(sf::Vertex *quad, std::uint8_t flips)
+{
+	if (flips == 0) {
+		return;
+	}
+
+	// Corners are top left, top right, bottom right, bottom left.
+	const int horizontal[4] = {1, 0, 3, 2};
+	const int vertical[4] = {3, 2, 1, 0};
+	const int diagonal[4] = {0, 3, 2, 1};
+
+	sf::Vector2f texCoords[4];
+
+	for (int corner = 0; corner < 4; corner++) {
+		int source = corner;
+
+		if (flips & FLIP_VERTICAL) {
+			source = vertical[source];
+		}
+
+		if (flips & FLIP_HORIZONTAL) {
+			source = horizontal[source];
+		}
+
+		if (flips & FLIP_DIAGONAL) {
+			source = diagonal[source];
+		}
+
+		texCoords[corner] = quad[source].texCoords;
+	}
+
+	for (int corner = 0; corner < 4; corner++) {
+		quad[corner].texCoords = texCoords[corner];
+	}
+}
+
+// Append the item as four sf::Quads vertices.
+inline void appendQuad(std::vector<sf::Vertex> &vertices, const Item &item)
+{
+	float left = item.bounds.left;
+	float top = item.bounds.top;
+	float right = left + item.bounds.width;
+	float bottom = top + item.bounds.height;
+
+	float texLeft = static_cast<float>(item.textureRect.left);
+	float texTop = static_cast<float>(item.textureRect.top);
+	float texRight = texLeft + static_cast<float>(item.textureRect.width);
+	float texBottom = texTop + static_cast<float>(item.textureRect.height);
+
+	vertices.push_back(
+	    sf::Vertex(sf::Vector2f(left, top), item.color, sf::Vector2f(texLeft, texTop)));
+	vertices.push_back(
+	    sf::Vertex(sf::Vector2f(right, top), item.color, sf::Vector2f(texRight, texTop)));
+	vertices.push_back(
+	    sf::Vertex(sf::Vector2f(right, bottom), item.color, sf::Vector2f(texRight, texBottom)));
+	vertices.push_back(
+	    sf::Vertex(sf::Vector2f(left, bottom), item.color, sf::Vector2f(texLeft, texBottom)));
+
+	flipQuad(&vertices[vertices.size() - 4], item.flips);
+}
+} // namespace render
+
+#endif
@@ -0,0 +1,69 @@
+#include "snapshot.hpp"
+
+void render::Snapshot::clear()
+{
+	// Keep the capacity so a steady scene doesn't allocate every frame.
+
+	mVertices.clear();
+	mBatches.clear();
+	mViews.clear();
+	hudText.clear();
+}
+
+void render::Snapshot::draw(const sf::Vertex *vertices, std::size_t count,
+			    sf::PrimitiveType type, const sf::RenderStates &states)
+{
+	if (count == 0) {
+		return;
+	}
+
+	// Strips and fans can't be joined, every other primitive type merges with the last batch
+	// when it was drawn with the same states and view.
+	bool mergeable =
+	    type != sf::LineStrip && type != sf::TriangleStrip && type != sf::TriangleFan;
+	std::size_t view = mViews.empty() ? NO_VIEW : mViews.size() - 1;
+
+	const Batch *last = mBatches.empty() ? nullptr : &mBatches.back();
+
+	if (!mergeable || last == nullptr || last->texture != states.texture ||
+	    last->shader != states.shader || last->blendMode != states.blendMode ||
+	    last->type != type || last->view != view) {
+		mBatches.push_back(Batch{states.texture, states.shader, states.blendMode, type,
+					 view, mVertices.size(), 0});
+	}
+
+	mBatches.back().count += count;
+
+	for (std::size_t i = 0; i < count; i++) {
+		sf::Vertex vertex = vertices[i];
+		vertex.position = states.transform.transformPoint(vertex.position);
+
+		mVertices.push_back(vertex);
+	}
+}
+
+void render::Snapshot::setView(const sf::View &view)
+{
+	mViews.push_back(view);
+}
+
+void render::Snapshot::replay(Target &target) const
+{
+	std::size_t view = NO_VIEW;
+
+	for (const Batch &batch : mBatches) {
+		if (batch.view != view) {
+			view = batch.view;
+			target.setView(mViews[view]);
+		}
+
+		sf::RenderStates states(batch.blendMode, sf::Transform::Identity, batch.texture,
+					batch.shader);
+		target.draw(&mVertices[batch.first], batch.count, batch.type, states);
+	}
+
+	// A view set after the last draw is still left on the target.
+	if (!mViews.empty() && view != mViews.size() - 1) {
+		target.setView(mViews.back());
+	}
+}
@@ -0,0 +1,60 @@
+#ifndef RENDER_SNAPSHOT_HPP
+#define RENDER_SNAPSHOT_HPP
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+#include "target.hpp"
+
+namespace render
+{
+/* Everything needed to draw one frame, detached from the game state that produced it.
+ * The simulation draws into one like any other target and the renderer replays it,
+ * possibly on another thread. Textures and shaders are kept as pointers, they have to
+ * outlive the frame. */
+class Snapshot : public Target
+{
+public:
+	// Batches drawn before the first setView leave the target's view alone.
+	static const std::size_t NO_VIEW = static_cast<std::size_t>(-1);
+
+	struct Batch {
+		const sf::Texture *texture;
+		const sf::Shader *shader;
+		sf::BlendMode blendMode;
+		sf::PrimitiveType type;
+		std::size_t view; // Index into the views set so far, or NO_VIEW.
+		std::size_t first;
+		std::size_t count;
+	};
+
+	std::string hudText;
+
+	void clear();
+
+	// Transforms are baked into the stored vertices so consecutive draws can be merged.
+	void draw(const sf::Vertex *vertices, std::size_t count, sf::PrimitiveType type,
+		  const sf::RenderStates &states = sf::RenderStates::Default) override;
+	void setView(const sf::View &view) override;
+
+	void replay(Target &target) const;
+
+	std::size_t getVertexCount() const
+	{
+		return mVertices.size();
+	}
+
+	std::size_t getBatchCount() const
+	{
+		return mBatches.size();
+	}
+
+private:
+	std::vector<sf::Vertex> mVertices;
+	std::vector<Batch> mBatches;
+	std::vector<sf::View> mViews;
+};
+} // namespace render
+
+#endif
@@ -0,0 +1,76 @@
+#include "target.hpp"
+
+#include <algorithm>
+
+void render::RecordingTarget::draw(const sf::Vertex *vertices, std::size_t count,
+				   sf::PrimitiveType type, const sf::RenderStates &states)
+{
+	if (count == 0) {
+		return;
+	}
+
+	mStats.drawCalls++;
+	mStats.vertices += count;
+
+	// A texture switch is counted the way the GPU sees it, unbinding isn't a bind.
+	if (states.texture != nullptr && (!mHasState || states.texture != mTexture)) {
+		mStats.textureBinds++;
+	}
+
+	if (mHasState && (states.texture != mTexture || states.shader != mShader ||
+			  states.blendMode != mBlendMode || type != mType)) {
+		mStats.stateChanges++;
+	}
+
+	mHasState = true;
+	mTexture = states.texture;
+	mShader = states.shader;
+	mBlendMode = states.blendMode;
+	mType = type;
+
+	// Approximate fill with the bounding box of each quad or triangle, points cover a pixel.
+	std::size_t stride = 1;
+	if (type == sf::Quads) {
+		stride = 4;
+	} else if (type == sf::Triangles) {
+		stride = 3;
+	}
+
+	if (stride == 1) {
+		mStats.fillArea += type == sf::Points ? static_cast<double>(count) : 0.0;
+		return;
+	}
+
+	for (std::size_t i = 0; i + stride <= count; i += stride) {
+		sf::Vector2f first = states.transform.transformPoint(vertices[i].position);
+		sf::Vector2f min = first;
+		sf::Vector2f max = first;
+
+		for (std::size_t j = 1; j < stride; j++) {
+			sf::Vector2f point =
+			    states.transform.transformPoint(vertices[i + j].position);
+
+			min.x = std::min(min.x, point.x);
+			min.y = std::min(min.y, point.y);
+			max.x = std::max(max.x, point.x);
+			max.y = std::max(max.y, point.y);
+		}
+
+		double area =
+		    static_cast<double>(max.x - min.x) * static_cast<double>(max.y - min.y);
+		mStats.fillArea += stride == 3 ? area / 2.0 : area;
+	}
+}
+
+void render::RecordingTarget::setView(const sf::View &)
+{
+	mStats.viewChanges++;
+}
+
+void render::RecordingTarget::reset()
+{
+	mStats = Stats{};
+	mHasState = false;
+	mTexture = nullptr;
+	mShader = nullptr;
+}
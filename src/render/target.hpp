@@ -0,0 +1,79 @@
+#ifndef RENDER_TARGET_HPP
+#define RENDER_TARGET_HPP
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+
+namespace render
+{
+/* What the engine's draw paths draw into. Everything is expressed as vertex arrays so a
+ * target can forward to SFML, record a frame, or just count what it was asked to do. */
+class Target
+{
+public:
+	virtual ~Target() = default;
+
+	virtual void draw(const sf::Vertex *vertices, std::size_t count, sf::PrimitiveType type,
+			  const sf::RenderStates &states = sf::RenderStates::Default) = 0;
+	virtual void setView(const sf::View &view) = 0;
+};
+
+// Forwards to a real SFML render target (window or render texture).
+class SfmlTarget : public Target
+{
+public:
+	explicit SfmlTarget(sf::RenderTarget &target) : mTarget(target)
+	{
+	}
+
+	void draw(const sf::Vertex *vertices, std::size_t count, sf::PrimitiveType type,
+		  const sf::RenderStates &states = sf::RenderStates::Default) override
+	{
+		mTarget.draw(vertices, count, type, states);
+	}
+
+	void setView(const sf::View &view) override
+	{
+		mTarget.setView(view);
+	}
+
+private:
+	sf::RenderTarget &mTarget;
+};
+
+// Counts draw calls, vertices, texture binds, state changes and covered area, no GPU needed.
+class RecordingTarget : public Target
+{
+public:
+	struct Stats {
+		unsigned int drawCalls;
+		std::size_t vertices;
+		unsigned int textureBinds;
+		unsigned int stateChanges;
+		unsigned int viewChanges;
+		double fillArea; // Sum of the primitives' bounding box areas, in world units.
+	};
+
+	void draw(const sf::Vertex *vertices, std::size_t count, sf::PrimitiveType type,
+		  const sf::RenderStates &states = sf::RenderStates::Default) override;
+	void setView(const sf::View &view) override;
+
+	const Stats &getStats() const
+	{
+		return mStats;
+	}
+
+	void reset();
+
+private:
+	Stats mStats{};
+
+	bool mHasState = false;
+	const sf::Texture *mTexture = nullptr;
+	const sf::Shader *mShader = nullptr;
+	sf::BlendMode mBlendMode;
+	sf::PrimitiveType mType = sf::Points;
+};
+} // namespace render
+
+#endif
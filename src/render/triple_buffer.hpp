@@ -0,0 +1,54 @@
+#ifndef RENDER_TRIPLE_BUFFER_HPP
+#define RENDER_TRIPLE_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+
+namespace render
+{
+/* Lock free hand-off between one producer and one consumer thread. The producer always has a
+ * buffer to write into and the consumer always reads the newest complete one, neither waits. */
+template <typename T>
+class TripleBuffer
+{
+public:
+	T &writeBuffer()
+	{
+		return mBuffers[mWriteIndex];
+	}
+
+	// Producer: hand the write buffer over and take the spare one.
+	void publish()
+	{
+		mWriteIndex =
+		    mMiddle.exchange(mWriteIndex | FRESH, std::memory_order_acq_rel) & INDEX;
+	}
+
+	// Consumer: swap in the newest published buffer, returns false if nothing new arrived.
+	bool consume()
+	{
+		if ((mMiddle.load(std::memory_order_acquire) & FRESH) == 0) {
+			return false;
+		}
+
+		mReadIndex = mMiddle.exchange(mReadIndex, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+
+	const T &readBuffer() const
+	{
+		return mBuffers[mReadIndex];
+	}
+
+private:
+	static constexpr unsigned int INDEX = 3;
+	static constexpr unsigned int FRESH = 4;
+
+	std::array<T, 3> mBuffers;
+	unsigned int mWriteIndex = 0;
+	unsigned int mReadIndex = 1;
+	std::atomic<unsigned int> mMiddle{2};
+};
+} // namespace render
+
+#endif
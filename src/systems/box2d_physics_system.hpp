@@ -0,0 +1,280 @@
+#ifndef SYSTEMS_BOX2D_PHYSICS_SYSTEM
+#define SYSTEMS_BOX2D_PHYSICS_SYSTEM
+
+#include <Box2D/Box2D.h>
+#include <SFML/System/Time.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../debug.hpp"
+#include "../defs.hpp"
+#include "../ecs.hpp"
+
+#include "../tmx-parser/map.hpp"
+
+#include "../components/collision_filter.hpp"
+#include "../components/renderable.hpp"
+#include "../components/rigidbody.hpp"
+#include "../components/transform.hpp"
+
+class Game;
+
+/* Runs the same bodies as RigidPhysicsSystem through a b2World instead, for scenes heavy
+ * enough to want Box2D's dynamic tree, islands and sleeping. Bodies follow the same contract:
+ * the ECS position has already been moved by velocity this tick, and the move is replayed
+ * from where it started. Blocking tiles become one static body per collision category. */
+class Box2DPhysicsSystem : public ecs::System
+{
+public:
+	void init(ecs::Coordinator *coordinator, Game *game)
+	{
+		mCoordinator = coordinator;
+		mGame = game;
+		mWorld = std::make_unique<b2World>(b2Vec2(0.f, 0.f));
+		mWorld->SetAllowSleeping(true);
+	}
+
+	// Velocities are in pixels per second.
+	void update(tmx::Map *map, sf::Time deltaTime)
+	{
+		float step = deltaTime.asSeconds();
+
+		// Infinite maps change their static geometry as chunks stream in and out.
+		if (map != mStaticMap ||
+		    (map != nullptr && map->getCollisionRevision() != mStaticRevision)) {
+			buildStatic(map);
+		}
+
+		syncBodies(step);
+		mWorld->Step(step, DEF_BOX2D_VELOCITY_ITERATIONS, DEF_BOX2D_POSITION_ITERATIONS);
+
+		// Bodies that were already asleep didn't move, the rest are written back. One that
+		// just fell asleep is written once more so its velocity reads as zero.
+		for (auto const &entity : mEntities) {
+			Mirror &mirror = mMirrors[entity];
+			bool wasAwake = mirror.awake;
+			mirror.awake = mirror.body->IsAwake();
+
+			if (!mirror.awake && !wasAwake) {
+				continue;
+			}
+
+			auto &rigidbody = mCoordinator->getComponent<RigidBody>(entity);
+			auto &transform = mCoordinator->getComponent<Transform>(entity);
+			auto const &renderable = mCoordinator->getComponent<Renderable>(entity);
+
+			transform.position =
+			    toPixels(mirror.body->GetPosition()) - renderable.size / 2.f;
+			rigidbody.velocity = toPixels(mirror.body->GetLinearVelocity());
+
+			mirror.position = transform.position;
+			mirror.velocity = rigidbody.velocity;
+		}
+	}
+
+private:
+	// A body and what the ECS looked like when it was last written back, any difference
+	// means something outside the physics moved it.
+	struct Mirror {
+		b2Body *body = nullptr;
+		std::uint32_t seenTick = 0;
+		bool awake = true;
+		sf::Vector2f position;
+		sf::Vector2f velocity;
+	};
+
+	// Create bodies for new entities, push outside changes into Box2D and drop bodies that
+	// left the system.
+	void syncBodies(float step)
+	{
+		mTick++;
+		if (mMirrors.size() < ecs::MAX_ENTITIES) {
+			mMirrors.resize(ecs::MAX_ENTITIES);
+		}
+
+		for (auto const &entity : mEntities) {
+			auto const &rigidbody = mCoordinator->getComponent<RigidBody>(entity);
+			auto const &transform = mCoordinator->getComponent<Transform>(entity);
+			auto const &renderable = mCoordinator->getComponent<Renderable>(entity);
+
+			Mirror &mirror = mMirrors[entity];
+			mirror.seenTick = mTick;
+
+			if (mirror.body == nullptr) {
+				mirror.body = createBody(entity, renderable.size);
+			} else if (transform.position == mirror.position &&
+				   rigidbody.velocity == mirror.velocity) {
+				// Untouched since the last step, leave Box2D free to let it sleep.
+				continue;
+			}
+
+			sf::Vector2f start =
+			    transform.position - rigidbody.velocity * step + renderable.size / 2.f;
+
+			mirror.body->SetTransform(toMeters(start), 0.f);
+			mirror.body->SetLinearVelocity(toMeters(rigidbody.velocity));
+			mirror.body->SetAwake(true);
+			mirror.awake = true;
+		}
+
+		for (std::size_t i = 0; i < mTracked.size();) {
+			Mirror &mirror = mMirrors[mTracked[i]];
+
+			if (mirror.seenTick == mTick) {
+				i++;
+				continue;
+			}
+
+			mWorld->DestroyBody(mirror.body);
+			mirror = Mirror{};
+			mTracked[i] = mTracked.back();
+			mTracked.pop_back();
+		}
+	}
+
+	b2Body *createBody(ecs::Entity entity, sf::Vector2f size)
+	{
+		CollisionFilter filter;
+		if (mCoordinator->hasComponent<CollisionFilter>(entity)) {
+			filter = mCoordinator->getComponent<CollisionFilter>(entity);
+		}
+
+		b2BodyDef bodyDef;
+		bodyDef.type = b2_dynamicBody;
+		bodyDef.fixedRotation = true;
+		bodyDef.userData = reinterpret_cast<void *>(static_cast<std::uintptr_t>(entity));
+
+		b2PolygonShape shape;
+		shape.SetAsBox(size.x / 2.f / DEF_PIXELS_PER_METER,
+			       size.y / 2.f / DEF_PIXELS_PER_METER);
+
+		b2FixtureDef fixtureDef;
+		fixtureDef.shape = &shape;
+		fixtureDef.density = 1.f;
+		fixtureDef.friction = 0.f;
+		fixtureDef.filter = toB2Filter(filter.category, filter.mask);
+
+		if (!fitsB2Filter(filter.category, filter.mask)) {
+			warnFilter("Entity " + std::to_string(entity), filter.category,
+				   filter.mask);
+		}
+
+		b2Body *body = mWorld->CreateBody(&bodyDef);
+		body->CreateFixture(&fixtureDef);
+
+		mTracked.push_back(entity);
+		return body;
+	}
+
+	// One static body per collision category, a box fixture for each merged rect.
+	void buildStatic(tmx::Map *map)
+	{
+		for (b2Body *body : mStaticBodies) {
+			mWorld->DestroyBody(body);
+		}
+
+		mStaticBodies.clear();
+		mStaticMap = map;
+
+		if (map == nullptr) {
+			return;
+		}
+
+		mStaticRevision = map->getCollisionRevision();
+
+		for (auto const &collision : map->collisionLayers) {
+			// Infinite maps rebuild these as chunks stream, each category warns once.
+			if (!fitsB2Filter(collision.category, 0xFFFFFFFF) &&
+			    std::find(mWarnedCategories.begin(), mWarnedCategories.end(),
+				      collision.category) == mWarnedCategories.end()) {
+				mWarnedCategories.push_back(collision.category);
+				warnFilter("The collision layer", collision.category, 0xFFFFFFFF);
+			}
+
+			b2BodyDef bodyDef;
+			bodyDef.type = b2_staticBody;
+
+			b2Body *body = mWorld->CreateBody(&bodyDef);
+			mStaticBodies.push_back(body);
+
+			mStaticRects.clear();
+			collision.getRects(mStaticRects);
+
+			for (auto const &rect : mStaticRects) {
+				sf::Vector2f halfSize(rect.width / 2.f, rect.height / 2.f);
+				sf::Vector2f center = sf::Vector2f(rect.left, rect.top) + halfSize;
+
+				b2PolygonShape shape;
+				shape.SetAsBox(halfSize.x / DEF_PIXELS_PER_METER,
+					       halfSize.y / DEF_PIXELS_PER_METER, toMeters(center),
+					       0.f);
+
+				b2FixtureDef fixtureDef;
+				fixtureDef.shape = &shape;
+				fixtureDef.friction = 0.f;
+				fixtureDef.filter = toB2Filter(collision.category, 0xFFFFFFFF);
+
+				body->CreateFixture(&fixtureDef);
+			}
+		}
+	}
+
+	// Box2D filters are 16 bits wide, categories above that can't be represented.
+	static b2Filter toB2Filter(std::uint32_t category, std::uint32_t mask)
+	{
+		b2Filter filter;
+		filter.categoryBits = static_cast<uint16>(category & 0xFFFF);
+		filter.maskBits = static_cast<uint16>(mask & 0xFFFF);
+
+		return filter;
+	}
+
+	// A mask with all the upper bits set still collides with everything without them.
+	static bool fitsB2Filter(std::uint32_t category, std::uint32_t mask)
+	{
+		std::uint32_t upperMask = mask >> 16;
+		return (category >> 16) == 0 && (upperMask == 0 || upperMask == 0xFFFF);
+	}
+
+	static void warnFilter(const std::string &owner, std::uint32_t category,
+			       std::uint32_t mask)
+	{
+		std::ostringstream msg;
+		msg << owner << " has collision category 0x" << std::hex << category
+		    << " and mask 0x" << mask << ", Box2D drops the bits above 15.";
+
+		dbg::printMessage(msg.str().c_str(), dbg::Urgency::WARNING);
+	}
+
+	static b2Vec2 toMeters(sf::Vector2f pixels)
+	{
+		return b2Vec2(pixels.x / DEF_PIXELS_PER_METER, pixels.y / DEF_PIXELS_PER_METER);
+	}
+
+	static sf::Vector2f toPixels(const b2Vec2 &meters)
+	{
+		return sf::Vector2f(meters.x * DEF_PIXELS_PER_METER,
+				    meters.y * DEF_PIXELS_PER_METER);
+	}
+
+	std::unique_ptr<b2World> mWorld;
+	std::vector<Mirror> mMirrors; // By entity
+	std::vector<ecs::Entity> mTracked;
+	std::uint32_t mTick = 0;
+
+	const tmx::Map *mStaticMap = nullptr;
+	unsigned int mStaticRevision = 0;
+	std::vector<sf::Rect<float>> mStaticRects;
+	std::vector<b2Body *> mStaticBodies;
+	std::vector<std::uint32_t> mWarnedCategories; // Collision layers already warned about.
+
+private:
+	ecs::Coordinator *mCoordinator;
+	Game *mGame;
+};
+
+#endif
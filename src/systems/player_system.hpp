@@ -2,6 +2,7 @@
 #define SYSTEMS_PLAYER_SYSTEM_HPP
 
 #include <SFML/Graphics/View.hpp>
+#include <SFML/System/Time.hpp>
 #include <SFML/Window/Keyboard.hpp>
 
 #include "../ecs.hpp"
@@ -43,6 +44,11 @@ public:
 							transform.position.y =
 							    (obj.y + (obj.height / 2)) -
 							    (renderable.size.y / 2);
+
+							// Teleported, don't blend from the old
+							// position.
+							transform.previousPosition =
+							    transform.position;
 							break;
 
 						default:
@@ -53,46 +59,51 @@ public:
 		}
 	}
 
-	void update(sf::View *gameView)
+	// Speeds are in pixels per second, acceleration and deceleration per second squared.
+	void update(sf::Time deltaTime)
 	{
+		float dt = deltaTime.asSeconds();
+
 		for (auto const &entity : mEntities) {
 			auto &transform = mCoordinator->getComponent<Transform>(entity);
 			auto &rigidBody = mCoordinator->getComponent<RigidBody>(entity);
 			auto &movement = mCoordinator->getComponent<MovementNew>(entity);
 			auto &player = mCoordinator->getComponent<Player>(entity);
-			auto &renderable = mCoordinator->getComponent<Renderable>(entity);
+
+			sf::Vector2f acceleration = rigidBody.acceleration * dt;
+			sf::Vector2f deceleration = rigidBody.deceleration * dt;
 
 			if (movement.running) {
 				if (movement.right && rigidBody.velocity.x < player.maxRunSpeed) {
-					rigidBody.velocity.x += rigidBody.acceleration.x;
+					rigidBody.velocity.x += acceleration.x;
 				}
 
 				if (movement.left && rigidBody.velocity.x > -player.maxRunSpeed) {
-					rigidBody.velocity.x -= rigidBody.acceleration.x;
+					rigidBody.velocity.x -= acceleration.x;
 				}
 
 				if (movement.up && rigidBody.velocity.y > -player.maxRunSpeed) {
-					rigidBody.velocity.y -= rigidBody.acceleration.y;
+					rigidBody.velocity.y -= acceleration.y;
 				}
 
 				if (movement.down && rigidBody.velocity.y < player.maxRunSpeed) {
-					rigidBody.velocity.y += rigidBody.acceleration.y;
+					rigidBody.velocity.y += acceleration.y;
 				}
 			} else {
 				if (movement.right && rigidBody.velocity.x < player.maxWalkSpeed) {
-					rigidBody.velocity.x += rigidBody.acceleration.x;
+					rigidBody.velocity.x += acceleration.x;
 				}
 
 				if (movement.left && rigidBody.velocity.x > -player.maxWalkSpeed) {
-					rigidBody.velocity.x -= rigidBody.acceleration.x;
+					rigidBody.velocity.x -= acceleration.x;
 				}
 
 				if (movement.up && rigidBody.velocity.y > -player.maxWalkSpeed) {
-					rigidBody.velocity.y -= rigidBody.acceleration.y;
+					rigidBody.velocity.y -= acceleration.y;
 				}
 
 				if (movement.down && rigidBody.velocity.y < player.maxWalkSpeed) {
-					rigidBody.velocity.y += rigidBody.acceleration.y;
+					rigidBody.velocity.y += acceleration.y;
 				}
 
 				// Clamp the run speed.
@@ -119,37 +130,50 @@ public:
 
 			// Apply deceleration on X
 			if (rigidBody.velocity.x > 0 && !movement.right) {
-				if (rigidBody.velocity.x < rigidBody.deceleration.x) {
+				if (rigidBody.velocity.x < deceleration.x) {
 					rigidBody.velocity.x = 0;
 				} else {
-					rigidBody.velocity.x -= rigidBody.deceleration.x;
+					rigidBody.velocity.x -= deceleration.x;
 				}
 			} else if (rigidBody.velocity.x < 0 && !movement.left) {
-				if (rigidBody.velocity.x > rigidBody.deceleration.x) {
+				if (rigidBody.velocity.x > -deceleration.x) {
 					rigidBody.velocity.x = 0;
 				} else {
-					rigidBody.velocity.x += rigidBody.deceleration.x;
+					rigidBody.velocity.x += deceleration.x;
 				}
 			}
-			transform.position.x += rigidBody.velocity.x;
+			transform.position.x += rigidBody.velocity.x * dt;
 
 			// Apply acceleration on Y
 			if (rigidBody.velocity.y > 0 && !movement.down) {
-				if (rigidBody.velocity.y < rigidBody.deceleration.y) {
+				if (rigidBody.velocity.y < deceleration.y) {
 					rigidBody.velocity.y = 0;
 				} else {
-					rigidBody.velocity.y -= rigidBody.deceleration.y;
+					rigidBody.velocity.y -= deceleration.y;
 				}
 			} else if (rigidBody.velocity.y < 0 && !movement.up) {
-				if (rigidBody.velocity.y > rigidBody.deceleration.y) {
+				if (rigidBody.velocity.y > -deceleration.y) {
 					rigidBody.velocity.y = 0;
 				} else {
-					rigidBody.velocity.y += rigidBody.deceleration.y;
+					rigidBody.velocity.y += deceleration.y;
 				}
 			}
-			transform.position.y += rigidBody.velocity.y;
+			transform.position.y += rigidBody.velocity.y * dt;
+		}
+	}
+
+	// Center the view on the player where it's drawn, between its last two ticks.
+	void followCamera(sf::View *gameView, float alpha)
+	{
+		for (auto const &entity : mEntities) {
+			auto &transform = mCoordinator->getComponent<Transform>(entity);
+			auto &renderable = mCoordinator->getComponent<Renderable>(entity);
+
+			Transform drawn = transform;
+			drawn.position = transform.previousPosition +
+					 (transform.position - transform.previousPosition) * alpha;
 
-			gameView->setCenter(getCenter(renderable, transform));
+			gameView->setCenter(getCenter(renderable, drawn));
 		}
 	}
 
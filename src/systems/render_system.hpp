@@ -2,10 +2,14 @@
 #define SYSTEMS_RENDER_SYSTEM_HPP
 
 #include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <vector>
 
 #include "../ecs.hpp"
 #include "../game.hpp"
 
+#include "../render/render_item.hpp"
+#include "../render/target.hpp"
 #include "../tmx-parser/map.hpp"
 
 #include "../components/renderable.hpp"
@@ -20,48 +24,74 @@ public:
 		mGame = game;
 	}
 
-	void draw(tmx::Map *map, sf::Time time, sf::Rect<float> region)
+	// Copy every position into previousPosition, called before a tick moves anything.
+	void beginTick()
 	{
-		// I have no clue what a better way to sort sets would be.
-		std::set<ecs::Entity, EntityComparator> srtd(
-		    {}, EntityComparator{.sCoordinator = mCoordinator});
-		for (auto &entity : mEntities) {
-			srtd.insert(entity);
+		for (auto const &entity : mEntities) {
+			auto &transform = mCoordinator->getComponent<Transform>(entity);
+			transform.previousPosition = transform.position;
 		}
+	}
 
-		map->drawRegion(mGame->window, time, region);
+	// Entities are drawn alpha of the way from their previous to their current position.
+	void draw(tmx::Map *map, render::Target &target, sf::Rect<float> region, float alpha = 1.f)
+	{
+		map->drawRegion(target, region);
 
-		// Draw the sorted set.
-		for (auto const &entity : srtd) {
+		// Entities and overlay tiles share one depth sort, so an overlay tile is drawn
+		// once no matter how many entities stand near it.
+		mItems.clear();
+		for (auto const &entity : mEntities) {
 			auto const &transform = mCoordinator->getComponent<Transform>(entity);
 			auto const &renderable = mCoordinator->getComponent<Renderable>(entity);
 
+			sf::Vector2f moved = transform.position - transform.previousPosition;
+			sf::Vector2f position = transform.previousPosition + moved * alpha;
+
 			// Temporaraly draw a rectangle for the entities.
-			sf::RectangleShape rect(renderable.size);
-			rect.setPosition(transform.position);
-			rect.setFillColor(renderable.color);
-			mGame->window.draw(rect);
+			mItems.push_back(render::Item{
+			    .depth = position.y + renderable.size.y,
+			    .bounds = sf::FloatRect(position, renderable.size),
+			    .textureRect = sf::IntRect(),
+			    .texture = nullptr,
+			    .color = renderable.color,
+			});
+		}
 
-			map->drawPosition(mGame->window, time, transform);
+		map->collectOverlay(region, mItems);
+
+		std::stable_sort(mItems.begin(), mItems.end(), render::ItemComparator());
+
+		// Draw the sorted items, batching consecutive quads that share a texture.
+		mVertices.clear();
+		const sf::Texture *batchTexture = nullptr;
+
+		for (auto const &item : mItems) {
+			if (item.texture != batchTexture) {
+				flush(target, batchTexture);
+				batchTexture = item.texture;
+			}
+
+			render::appendQuad(mVertices, item);
 		}
+
+		flush(target, batchTexture);
 	}
 
 private:
-	struct EntityComparator {
-		bool operator()(const ecs::Entity &entity1, const ecs::Entity &entity2) const
-		{
-			auto const &transform1 = sCoordinator->getComponent<Transform>(entity1);
-			auto const &transform2 = sCoordinator->getComponent<Transform>(entity2);
-
-			if (transform1.position.y == transform2.position.y) {
-				return transform1.position.x < transform2.position.x;
-			}
-
-			return transform1.position.y < transform2.position.y;
+	void flush(render::Target &target, const sf::Texture *texture)
+	{
+		if (mVertices.empty()) {
+			return;
 		}
 
-		ecs::Coordinator *sCoordinator;
-	};
+		target.draw(mVertices.data(), mVertices.size(), sf::Quads,
+			    sf::RenderStates(texture));
+		mVertices.clear();
+	}
+
+	std::vector<render::Item> mItems;
+	std::vector<sf::Vertex> mVertices;
 
 private:
 	ecs::Coordinator *mCoordinator;
@@ -1,14 +1,24 @@
 #ifndef SYSTEMS_RIGID_PHYSICS_SYSTEM
 #define SYSTEMS_RIGID_PHYSICS_SYSTEM
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <vector>
 
+#include "../defs.hpp"
 #include "../ecs.hpp"
+#include "../thread_pool.hpp"
 
 #include "../tmx-parser/map.hpp"
 
 #include "../physics/aabb.hpp"
+#include "../physics/broadphase.hpp"
+#include "../physics/contact_events.hpp"
+#include "../physics/queries.hpp"
+#include "../physics/spatial_hash_grid.hpp"
 
+#include "../components/collision_filter.hpp"
 #include "../components/renderable.hpp"
 #include "../components/rigidbody.hpp"
 #include "../components/transform.hpp"
@@ -22,112 +32,675 @@ public:
 	{
 		mCoordinator = coordinator;
 		mGame = game;
+		mBroadphase = std::make_unique<physics::SpatialHashGrid>();
 	}
 
-	void update(tmx::Map *map)
+	// Swap the broadphase, existing bodies are re-added on the next update.
+	void setBroadphase(std::unique_ptr<physics::Broadphase> broadphase)
 	{
-		// I have no clue what a better way to sort sets would be.
-		std::set<ecs::Entity, EntityComparator> srtd(
-		    {}, EntityComparator{.sCoordinator = mCoordinator});
-		for (auto &entity : mEntities) {
-			srtd.insert(entity);
+		mBroadphase = std::move(broadphase);
+		mTracked.clear();
+	}
+
+	// Wake a sleeping body so it's simulated again from the next tick.
+	void wake(ecs::Entity entity)
+	{
+		if (entity < mSleep.size()) {
+			mSleep[entity].sleeping = false;
+			mSleep[entity].stillTicks = 0;
 		}
+	}
 
-		for (auto const &entity : srtd) {
-			auto &rigidbody = mCoordinator->getComponent<RigidBody>(entity);
-			auto &transform = mCoordinator->getComponent<Transform>(entity);
-			auto const &renderable = mCoordinator->getComponent<Renderable>(entity);
+	// Change a body's velocity (pixels per second) from outside the simulation.
+	void applyImpulse(ecs::Entity entity, sf::Vector2f impulse)
+	{
+		mCoordinator->getComponent<RigidBody>(entity).velocity += impulse;
+		wake(entity);
+	}
+
+	// Threads used to solve islands, the result is the same for any count.
+	void setThreadCount(unsigned int threads)
+	{
+		if (threads != mPool.getThreadCount()) {
+			mPool.resize(std::max(1u, threads));
+		}
+	}
+
+	bool isSleeping(ecs::Entity entity) const
+	{
+		return entity < mSleep.size() && mSleep[entity].sleeping;
+	}
+
+	std::size_t getAwakeCount() const
+	{
+		return mAwake.size();
+	}
+
+	// Contacts that began, continued or ended during the last tick. Read them after update,
+	// the next update clears them.
+	const physics::ContactEventBuffer &getContactEvents() const
+	{
+		return mEvents;
+	}
+
+	// Scene queries, see physics/queries.hpp. Bodies are where the last update left them.
+	bool raycast(const tmx::Map &map, const physics::Ray &ray, physics::RayHit &hit)
+	{
+		return physics::raycast(*mBroadphase, BoxLookup{this}, map, ray, hit);
+	}
+
+	void raycast(const tmx::Map &map, const std::vector<physics::Ray> &rays,
+		     std::vector<physics::RayHit> &hits)
+	{
+		physics::raycast(*mBroadphase, BoxLookup{this}, map, rays, hits);
+	}
+
+	void queryAABB(const tmx::Map &map, const physics::AABB &box, const CollisionFilter &filter,
+		       std::vector<std::uint32_t> &results)
+	{
+		physics::queryAABB(*mBroadphase, BoxLookup{this}, map, box, filter, results);
+	}
+
+	void queryCircle(const tmx::Map &map, sf::Vector2f center, float radius,
+			 const CollisionFilter &filter, std::vector<std::uint32_t> &results)
+	{
+		physics::queryCircle(*mBroadphase, BoxLookup{this}, map, center, radius, filter,
+				     results);
+	}
+
+	// Velocities are in pixels per second.
+	void update(tmx::Map *map, sf::Time deltaTime)
+	{
+		mStep = deltaTime.asSeconds();
+		syncBroadphase();
+
+		// Only awake bodies move, sleeping ones are just something to collide with.
+		buildIslands();
+
+		if (mScratch.size() < mPool.getThreadCount()) {
+			mScratch.resize(mPool.getThreadCount());
+		}
+
+		// Islands share no bodies, so solving them on any thread in any order gives the
+		// same result as solving them one after another.
+		mPool.run(mIslands.size(), [this, map](std::size_t index, unsigned int thread) {
+			const Island &island = mIslands[index];
+
+			for (std::size_t i = island.first; i < island.first + island.count; i++) {
+				Body &body = mBodies[mIslandBodies[i]];
+
+				sweepBody(body, map, mScratch[thread]);
+				updateSleep(body);
+			}
+		});
+
+		// The broadphase isn't thread safe, bodies that fell asleep get their exact box
+		// here.
+		for (auto const &body : mBodies) {
+			if (body.fellAsleep) {
+				mBroadphase->update(body.entity,
+						    physics::AABB{.min = body.transform->position,
+								  .max = body.transform->position +
+									 body.renderable->size},
+						    body.filter);
+			}
+		}
+
+		collectContacts(map);
+		emitContactEvents();
+	}
+
+private:
+	// An awake body with everything its sweep reads, looked up before the threads start.
+	struct Body {
+		ecs::Entity entity;
+		RigidBody *rigidbody;
+		Transform *transform;
+		const Renderable *renderable;
+		CollisionFilter filter;
+
+		// Broadphase hits for the swept box, a range of mCandidates.
+		std::size_t firstCandidate = 0;
+		std::size_t candidateCount = 0;
+
+		bool fellAsleep = false;
+	};
+
+	struct Candidate {
+		ecs::Entity entity;
+		const Transform *transform;
+		const Renderable *renderable;
+	};
 
-			physics::Object o1 =
-			    physics::valuesToObject(&rigidbody, &transform, &renderable);
+	// A range of mIslandBodies.
+	struct Island {
+		std::size_t first = 0;
+		std::size_t count = 0;
+	};
+
+	// Hands the scene queries the exact box of a body.
+	struct BoxLookup {
+		physics::AABB operator()(std::uint32_t entity) const
+		{
+			return system->currentBox(entity);
+		}
+
+		RigidPhysicsSystem *system;
+	};
+
+	// Per thread buffers for the static geometry queries.
+	struct Scratch {
+		std::vector<physics::AABB> staticBoxes;
+	};
+
+	// Sort the awake bodies x then y then id, look up everything the sweeps need and join
+	// bodies that could touch this tick into islands. Runs before any thread starts, so the
+	// sweeps never have to touch the ECS or the broadphase.
+	void buildIslands()
+	{
+		std::sort(mAwake.begin(), mAwake.end(), [this](ecs::Entity lhs, ecs::Entity rhs) {
+			sf::Vector2f lhsPosition =
+			    mCoordinator->getComponent<Transform>(lhs).position;
+			sf::Vector2f rhsPosition =
+			    mCoordinator->getComponent<Transform>(rhs).position;
+
+			if (lhsPosition.x != rhsPosition.x) {
+				return lhsPosition.x < rhsPosition.x;
+			}
+
+			if (lhsPosition.y != rhsPosition.y) {
+				return lhsPosition.y < rhsPosition.y;
+			}
 
-			// Iterate other entities.
-			for (auto const &entityCol : srtd) {
-				if (entity == entityCol) {
+			return lhs < rhs;
+		});
+
+		if (mParent.size() < ecs::MAX_ENTITIES) {
+			mParent.resize(ecs::MAX_ENTITIES);
+			mParentTick.resize(ecs::MAX_ENTITIES, 0);
+			mIslandTick.resize(ecs::MAX_ENTITIES, 0);
+			mIslandOf.resize(ecs::MAX_ENTITIES);
+		}
+
+		mBodies.clear();
+		mCandidates.clear();
+
+		for (auto const &entity : mAwake) {
+			Body body{
+			    .entity = entity,
+			    .rigidbody = &mCoordinator->getComponent<RigidBody>(entity),
+			    .transform = &mCoordinator->getComponent<Transform>(entity),
+			    .renderable = &mCoordinator->getComponent<Renderable>(entity),
+			    .filter = mFilters[entity],
+			    .firstCandidate = mCandidates.size(),
+			};
+
+			sf::Vector2f start =
+			    body.transform->position - body.rigidbody->velocity * mStep;
+
+			// Bodies near the swept box, in id order so the result doesn't depend on
+			// the grid.
+			mNearby.clear();
+			mBroadphase->query(
+			    sweptBox(start, body.transform->position, body.renderable->size),
+			    body.filter, mNearby);
+			std::sort(mNearby.begin(), mNearby.end());
+
+			for (ecs::Entity other : mNearby) {
+				if (other == entity) {
 					continue;
 				}
 
-				auto const &rigidbodyCol =
-				    mCoordinator->getComponent<RigidBody>(entityCol);
-				auto const &transformCol =
-				    mCoordinator->getComponent<Transform>(entityCol);
-				auto const &renderableCol =
-				    mCoordinator->getComponent<Renderable>(entityCol);
-
-				physics::Object o2 = physics::valuesToObject(
-				    &rigidbodyCol, &transformCol, &renderableCol);
-
-				// Apply collision
-				physics::Manifold manifold{
-				    .A = &o1,
-				    .B = &o2,
-				    .penetration = 0.f,
-				    .normal = sf::Vector2f(0.f, 0.f),
-				};
-				sf::Rect<float> intersection = physics::basicCollCheck(&manifold);
-
-				if (intersection.height != 0 || intersection.top != 0 ||
-				    intersection.left != 0 || intersection.width != 0) {
-					transform.position.x -= rigidbody.velocity.x;
-					rigidbody.velocity.x = 0;
-
-					transform.position.y -= rigidbody.velocity.y;
-					rigidbody.velocity.y = 0;
+				mCandidates.push_back(Candidate{
+				    .entity = other,
+				    .transform = &mCoordinator->getComponent<Transform>(other),
+				    .renderable = &mCoordinator->getComponent<Renderable>(other),
+				});
+				unite(entity, other);
+			}
+
+			body.candidateCount = mCandidates.size() - body.firstCandidate;
+			mBodies.push_back(body);
+		}
+
+		// Islands are numbered in order of their first body, and each keeps the bodies in
+		// the sorted order so a body sees its island exactly as a serial pass would.
+		mIslands.clear();
+		mIslandBodies.resize(mBodies.size());
+
+		for (auto const &body : mBodies) {
+			ecs::Entity root = findRoot(body.entity);
+
+			if (mIslandTick[root] != mTick) {
+				mIslandTick[root] = mTick;
+				mIslandOf[root] = static_cast<std::uint32_t>(mIslands.size());
+				mIslands.push_back(Island{});
+			}
+
+			mIslands[mIslandOf[root]].count++;
+		}
+
+		std::size_t first = 0;
+		for (auto &island : mIslands) {
+			island.first = first;
+			first += island.count;
+			island.count = 0;
+		}
+
+		for (std::size_t i = 0; i < mBodies.size(); i++) {
+			Island &island = mIslands[mIslandOf[findRoot(mBodies[i].entity)]];
+			mIslandBodies[island.first + island.count++] = i;
+		}
+
+		// Big islands first so one doesn't start last and hold up the whole tick.
+		auto bigger = [](const Island &lhs, const Island &rhs) {
+			return lhs.count > rhs.count;
+		};
+		std::sort(mIslands.begin(), mIslands.end(), bigger);
+	}
+
+	// Union find over entities, an entity not touched this tick is its own root.
+	ecs::Entity findRoot(ecs::Entity entity)
+	{
+		if (mParentTick[entity] < mTick) {
+			mParentTick[entity] = mTick;
+			mParent[entity] = entity;
+		}
+
+		while (mParent[entity] != entity) {
+			mParent[entity] = mParent[mParent[entity]];
+			entity = mParent[entity];
+		}
+
+		return entity;
+	}
+
+	void unite(ecs::Entity lhs, ecs::Entity rhs)
+	{
+		lhs = findRoot(lhs);
+		rhs = findRoot(rhs);
+
+		// The lower id becomes the root so islands come out the same every run.
+		if (lhs != rhs) {
+			mParent[std::max(lhs, rhs)] = std::min(lhs, rhs);
+		}
+	}
+
+	// Replay this tick's move from where the body started, stopping at the first contact and
+	// sliding along it for the rest of the move. Only touches the body's own island.
+	void sweepBody(Body &body, tmx::Map *map, Scratch &scratch)
+	{
+		ecs::Entity entity = body.entity;
+		RigidBody &rigidbody = *body.rigidbody;
+		Transform &transform = *body.transform;
+
+		sf::Vector2f displacement = rigidbody.velocity * mStep;
+		sf::Vector2f position = transform.position - displacement;
+		sf::Vector2f size = body.renderable->size;
+
+		const CollisionFilter &filter = body.filter;
+		std::vector<physics::AABB> &staticBoxes = scratch.staticBoxes;
+
+		// Static rects only need gathering if the swept box touches a blocked cell of a
+		// category the body collides with.
+		staticBoxes.clear();
+		sf::Rect<float> swept(std::min(position.x, transform.position.x),
+				      std::min(position.y, transform.position.y),
+				      std::abs(displacement.x) + size.x,
+				      std::abs(displacement.y) + size.y);
+
+		for (auto const &collision : map->collisionLayers) {
+			if ((collision.category & filter.mask) == 0 || !collision.overlaps(swept)) {
+				continue;
+			}
+
+			collision.query(swept, staticBoxes);
+		}
+
+		// A slide can hit at most one wall per axis, a third pass is just insurance.
+		for (int pass = 0; pass < 3; pass++) {
+			if (displacement.x == 0.f && displacement.y == 0.f) {
+				break;
+			}
+
+			physics::AABB box{.min = position, .max = position + size};
+
+			float toi = 1.f;
+			sf::Vector2f normal(0.f, 0.f);
+			physics::AABB hitBox{};
+			ecs::Entity hitEntity = entity;
+
+			auto earliest = [&](const physics::AABB &other, ecs::Entity otherEntity) {
+				float hitToi;
+				sf::Vector2f hitNormal;
+
+				if (physics::sweptAABB(box, displacement, other, hitToi,
+						       hitNormal) &&
+				    hitToi < toi) {
+					toi = hitToi;
+					normal = hitNormal;
+					hitBox = other;
+					hitEntity = otherEntity;
 				}
+			};
+
+			for (std::size_t i = 0; i < body.candidateCount; i++) {
+				const Candidate &other = mCandidates[body.firstCandidate + i];
+
+				earliest(physics::AABB{.min = other.transform->position,
+						       .max = other.transform->position +
+							      other.renderable->size},
+					 other.entity);
+			}
+
+			for (auto const &staticBox : staticBoxes) {
+				earliest(staticBox, entity);
 			}
 
-			// Iterate BLOCKING tiles
-			for (auto const &layer : map->layers) {
-				if (!layer.isBlocking) {
+			if (normal.x == 0.f && normal.y == 0.f) {
+				position += displacement;
+				break;
+			}
+
+			position += displacement * toi;
+			displacement *= 1.f - toi;
+
+			// Being hit wakes a sleeping body.
+			if (hitEntity != entity) {
+				wake(hitEntity);
+			}
+
+			// Snap flush to the contact so rounding can't leave the body overlapping,
+			// then drop the blocked part of the move.
+			if (normal.x != 0.f) {
+				position.x = normal.x < 0.f ? hitBox.min.x - size.x : hitBox.max.x;
+				displacement.x = 0.f;
+				rigidbody.velocity.x = 0.f;
+			} else {
+				position.y = normal.y < 0.f ? hitBox.min.y - size.y : hitBox.max.y;
+				displacement.y = 0.f;
+				rigidbody.velocity.y = 0.f;
+			}
+		}
+
+		transform.position = position;
+	}
+
+	// Where a body ended up after resolution.
+	physics::AABB currentBox(ecs::Entity entity)
+	{
+		auto const &transform = mCoordinator->getComponent<Transform>(entity);
+		auto const &renderable = mCoordinator->getComponent<Renderable>(entity);
+
+		return physics::AABB{.min = transform.position,
+				     .max = transform.position + renderable.size};
+	}
+
+	// Still in the system but not simulated this tick, so none of its contacts changed.
+	bool isResting(ecs::Entity entity) const
+	{
+		return mSeen[entity] == mTick && mSleep[entity].awakeTick != mTick;
+	}
+
+	// Find every contact of the bodies that moved, resting pairs keep last tick's contact.
+	void collectContacts(tmx::Map *map)
+	{
+		mContacts.clear();
+
+		for (auto const &contact : mPreviousContacts) {
+			if (isResting(contact.pair.a) &&
+			    (contact.pair.b == physics::STATIC_BODY || isResting(contact.pair.b))) {
+				mContacts.push_back(contact);
+			}
+		}
+
+		for (auto const &entity : mAwake) {
+			physics::AABB box = currentBox(entity);
+			const CollisionFilter &filter = mFilters[entity];
+
+			mNearby.clear();
+			mBroadphase->query(box, filter, mNearby);
+
+			for (ecs::Entity other : mNearby) {
+				// Pairs of moving bodies are found from the lower id only.
+				if (other == entity || (other < entity && !isResting(other))) {
+					continue;
+				}
+
+				Contact contact;
+				if (!physics::contactAABB(box, currentBox(other), contact.normal,
+							  contact.penetration)) {
 					continue;
 				}
 
-				float tileWidth = static_cast<float>(layer.tileset.tileWidth);
-				float tileHeight = static_cast<float>(layer.tileset.tileHeight);
+				if (other < entity) {
+					contact.normal = -contact.normal;
+				}
+
+				contact.pair =
+				    physics::Pair{std::min(entity, other), std::max(entity, other)};
+				mContacts.push_back(contact);
+			}
 
-				for (auto const &tileGroup : layer.tiles) {
-					for (auto const &tile : tileGroup) {
-						if (!tile.isBlocking) {
-							continue;
-						}
+			// All tiles count as one body, the deepest contact with them is kept.
+			Contact tiles{physics::Pair{entity, physics::STATIC_BODY}, {}, -1.f};
+
+			for (auto const &collision : map->collisionLayers) {
+				if ((collision.category & filter.mask) == 0) {
+					continue;
+				}
 
-						sf::Rect<float> tileCol(static_cast<float>(tile.x),
-									static_cast<float>(tile.y),
-									tileWidth, tileHeight);
+				mStaticBoxes.clear();
+				collision.query(sf::Rect<float>(box.min, box.max - box.min),
+						mStaticBoxes);
 
-						if (o1.rect.intersects(tileCol)) {
-							transform.position.x -=
-							    rigidbody.velocity.x;
-							rigidbody.velocity.x = 0;
+				for (const physics::AABB &tile : mStaticBoxes) {
+					Contact contact = tiles;
 
-							transform.position.y -=
-							    rigidbody.velocity.y;
-							rigidbody.velocity.y = 0;
-						}
+					if (physics::contactAABB(box, tile, contact.normal,
+								 contact.penetration) &&
+					    contact.penetration > tiles.penetration) {
+						tiles = contact;
 					}
 				}
 			}
+
+			if (tiles.penetration >= 0.f) {
+				mContacts.push_back(tiles);
+			}
 		}
+
+		std::sort(mContacts.begin(), mContacts.end());
 	}
 
-private:
-	// This isn't the same as the render systems comparator, this one sorts x, subsorts y.
-	struct EntityComparator {
-		bool operator()(const ecs::Entity &entity1, const ecs::Entity &entity2) const
-		{
-			auto const &transform1 = sCoordinator->getComponent<Transform>(entity1);
-			auto const &transform2 = sCoordinator->getComponent<Transform>(entity2);
+	// Compare this tick's contacts with last tick's, both sorted by pair.
+	void emitContactEvents()
+	{
+		mEvents.clear();
 
-			if (transform1.position.x == transform2.position.x) {
-				return transform1.position.y < transform2.position.y;
+		auto emit = [this](physics::ContactEvent::Type type, const Contact &contact) {
+			mEvents.push(physics::ContactEvent{
+			    .type = type,
+			    .a = contact.pair.a,
+			    .b = contact.pair.b,
+			    .normal = contact.normal,
+			    .penetration = contact.penetration,
+			});
+		};
+
+		std::size_t current = 0;
+		std::size_t previous = 0;
+
+		while (current < mContacts.size() || previous < mPreviousContacts.size()) {
+			if (previous == mPreviousContacts.size() ||
+			    (current < mContacts.size() &&
+			     mContacts[current] < mPreviousContacts[previous])) {
+				emit(physics::ContactEvent::BEGIN, mContacts[current++]);
+			} else if (current == mContacts.size() ||
+				   mPreviousContacts[previous] < mContacts[current]) {
+				emit(physics::ContactEvent::END, mPreviousContacts[previous++]);
+			} else {
+				emit(physics::ContactEvent::STAY, mContacts[current++]);
+				previous++;
 			}
+		}
+
+		std::swap(mContacts, mPreviousContacts);
+	}
+
+	// Box covering a body's whole move this tick.
+	static physics::AABB sweptBox(sf::Vector2f from, sf::Vector2f to, sf::Vector2f size)
+	{
+		return physics::AABB{
+		    .min = sf::Vector2f(std::min(from.x, to.x), std::min(from.y, to.y)),
+		    .max = sf::Vector2f(std::max(from.x, to.x), std::max(from.y, to.y)) + size,
+		};
+	}
 
-			return transform1.position.x < transform2.position.x;
+	// Push every awake body's box into the broadphase and drop bodies that left the system.
+	// A sleeping body keeps its last box and is woken if anything wrote to it.
+	void syncBroadphase()
+	{
+		mTick++;
+		if (mSeen.size() < ecs::MAX_ENTITIES) {
+			mSeen.resize(ecs::MAX_ENTITIES, 0);
+			mSleep.resize(ecs::MAX_ENTITIES);
+			mFilters.resize(ecs::MAX_ENTITIES);
 		}
 
-		ecs::Coordinator *sCoordinator;
+		mAwake.clear();
+
+		for (auto const &entity : mEntities) {
+			auto const &rigidbody = mCoordinator->getComponent<RigidBody>(entity);
+			auto const &transform = mCoordinator->getComponent<Transform>(entity);
+			auto const &renderable = mCoordinator->getComponent<Renderable>(entity);
+
+			mSeen[entity] = mTick;
+			SleepState &sleep = mSleep[entity];
+
+			CollisionFilter filter;
+			if (mCoordinator->hasComponent<CollisionFilter>(entity)) {
+				filter = mCoordinator->getComponent<CollisionFilter>(entity);
+			}
+
+			// Filters aren't compared for waking, a change is picked up once awake.
+			mFilters[entity] = filter;
+
+			if (sleep.sleeping && mBroadphase->contains(entity)) {
+				if (transform.position == sleep.position &&
+				    rigidbody.velocity == sleep.velocity) {
+					continue;
+				}
+
+				wake(entity);
+			}
+
+			// Cover the position the sweep starts from as well.
+			sf::Vector2f start = transform.position - rigidbody.velocity * mStep;
+			physics::AABB box = sweptBox(start, transform.position, renderable.size);
+
+			if (!mBroadphase->contains(entity)) {
+				mBroadphase->insert(entity, box, filter);
+				mTracked.push_back(entity);
+			} else {
+				mBroadphase->update(entity, box, filter);
+			}
+
+			sleep.awakeTick = mTick;
+			mAwake.push_back(entity);
+		}
+
+		for (std::size_t i = 0; i < mTracked.size();) {
+			if (mSeen[mTracked[i]] == mTick) {
+				i++;
+				continue;
+			}
+
+			mBroadphase->remove(mTracked[i]);
+			mSleep[mTracked[i]] = SleepState{};
+			mTracked[i] = mTracked.back();
+			mTracked.pop_back();
+		}
+	}
+
+	// Put a body to sleep once it's been nearly still for long enough.
+	void updateSleep(Body &body)
+	{
+		RigidBody &rigidbody = *body.rigidbody;
+
+		SleepState &sleep = mSleep[body.entity];
+		float speedSquared = physics::vecDot(rigidbody.velocity, rigidbody.velocity);
+
+		if (speedSquared > DEF_SLEEP_VELOCITY * DEF_SLEEP_VELOCITY) {
+			sleep.stillTicks = 0;
+			return;
+		}
+
+		if (++sleep.stillTicks < DEF_SLEEP_TICKS) {
+			return;
+		}
+
+		rigidbody.velocity = sf::Vector2f(0.f, 0.f);
+
+		sleep.sleeping = true;
+		sleep.position = body.transform->position;
+		sleep.velocity = rigidbody.velocity;
+		body.fellAsleep = true;
+	}
+
+	struct SleepState {
+		bool sleeping = false;
+		unsigned int stillTicks = 0;
+		std::uint32_t awakeTick = 0; // Last tick the body was simulated.
+
+		// What the body looked like when it fell asleep, any change wakes it.
+		sf::Vector2f position;
+		sf::Vector2f velocity;
 	};
 
+	std::unique_ptr<physics::Broadphase> mBroadphase;
+	std::vector<ecs::Entity> mTracked;
+	std::vector<std::uint32_t> mSeen; // Tick each entity was last synced, by entity
+	std::uint32_t mTick = 0;
+
+	std::vector<SleepState> mSleep; // By entity
+	std::vector<ecs::Entity> mAwake;
+
+	std::vector<std::uint32_t> mNearby;
+	struct Contact {
+		physics::Pair pair;
+		sf::Vector2f normal;
+		float penetration;
+
+		bool operator<(const Contact &rhs) const
+		{
+			return pair < rhs.pair;
+		}
+	};
+
+	// Sorted by pair, kept across ticks to tell begin, stay and end apart.
+	std::vector<Contact> mContacts;
+	std::vector<Contact> mPreviousContacts;
+	physics::ContactEventBuffer mEvents;
+
+	std::vector<CollisionFilter> mFilters; // By entity
+	std::vector<physics::AABB> mStaticBoxes;
+	float mStep = 0.f; // Seconds in the current tick
+
+	// Islands, rebuilt every tick. mIslandBodies holds indices into mBodies grouped by
+	// island, each island is a range of it.
+	std::vector<Body> mBodies;
+	std::vector<Candidate> mCandidates;
+	std::vector<Island> mIslands;
+	std::vector<std::size_t> mIslandBodies;
+	std::vector<ecs::Entity> mParent;       // By entity
+	std::vector<std::uint32_t> mParentTick; // By entity
+	std::vector<std::uint32_t> mIslandTick; // By root entity
+	std::vector<std::uint32_t> mIslandOf;   // By root entity
+
+	ThreadPool mPool;
+	std::vector<Scratch> mScratch; // By thread
+
 private:
 	ecs::Coordinator *mCoordinator;
 	Game *mGame;
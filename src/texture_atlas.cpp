@@ -0,0 +1,454 @@
+#include "texture_atlas.hpp"
+#include "debug.hpp"
+
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+
+TextureAtlas::TextureAtlas(unsigned int pageSize, unsigned int padding)
+    : pageSize(pageSize), padding(padding), usedArea(0)
+{
+}
+
+bool TextureAtlas::addImage(const std::string &name, const std::string &filename)
+{
+	// Queue an image file to be packed
+
+	sf::Image image;
+	if (!image.loadFromFile(filename)) {
+		std::ostringstream errMsg;
+		errMsg << "Texture atlas could not load \"" << filename << "\", skipping it.";
+
+		dbg::printMessage(errMsg.str().c_str(), dbg::Urgency::WARNING);
+		return false;
+	}
+
+	this->pending.push_back(Pending{name, image});
+	addSource(filename);
+	return true;
+}
+
+void TextureAtlas::addImage(const std::string &name, const sf::Image &image, sf::IntRect area)
+{
+	// Queue an image, or a sub-rect of one, to be packed
+
+	if (area.width <= 0 || area.height <= 0) {
+		this->pending.push_back(Pending{name, image});
+		return;
+	}
+
+	sf::Image subImage;
+	subImage.create(area.width, area.height, sf::Color::Transparent);
+	subImage.copy(image, 0, 0, area);
+
+	this->pending.push_back(Pending{name, subImage});
+}
+
+void TextureAtlas::addSource(const std::string &filename)
+{
+	SourceStamp stamp;
+
+	if (stampFile(filename, stamp)) {
+		this->sources[filename] = stamp;
+	}
+}
+
+bool TextureAtlas::pack()
+{
+	// Replace the current layout with every queued image
+
+	this->regions.clear();
+	this->pageImages.clear();
+	this->pages.clear();
+	this->usedArea = 0;
+
+	int size = static_cast<int>(std::min(this->pageSize, sf::Texture::getMaximumSize()));
+	int pad = static_cast<int>(this->padding);
+
+	// Tallest first keeps the skyline flat, the stable sort keeps the layout reproducible.
+	std::vector<std::size_t> order(this->pending.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [this](std::size_t lhs, std::size_t rhs) {
+		sf::Vector2u lhsSize = this->pending[lhs].image.getSize();
+		sf::Vector2u rhsSize = this->pending[rhs].image.getSize();
+
+		if (lhsSize.y == rhsSize.y) {
+			return lhsSize.x > rhsSize.x;
+		}
+
+		return lhsSize.y > rhsSize.y;
+	});
+
+	std::vector<Page> layouts;
+	std::vector<std::pair<std::size_t, Region>> placements;
+	bool packedAll = true;
+
+	for (std::size_t index : order) {
+		sf::Vector2u imageSize = this->pending[index].image.getSize();
+		int width = static_cast<int>(imageSize.x) + pad;
+		int height = static_cast<int>(imageSize.y) + pad;
+
+		if (width > size || height > size) {
+			std::ostringstream errMsg;
+			errMsg << "Texture atlas image \"" << this->pending[index].name
+			       << "\" is larger than a page (" << size << "px), skipping it.";
+
+			dbg::printMessage(errMsg.str().c_str(), dbg::Urgency::ERROR);
+			packedAll = false;
+			continue;
+		}
+
+		int x = 0;
+		int y = 0;
+		std::size_t node = 0;
+		std::size_t pageIndex = 0;
+
+		while (pageIndex < layouts.size() &&
+		       !findPosition(layouts[pageIndex], width, height, x, y, node)) {
+			pageIndex++;
+		}
+
+		if (pageIndex == layouts.size()) {
+			layouts.push_back(Page{{SkylineNode{0, 0, size}}, 0, 0});
+			findPosition(layouts[pageIndex], width, height, x, y, node);
+		}
+
+		placeRect(layouts[pageIndex], node, x, y, width, height);
+
+		Region region{static_cast<unsigned int>(pageIndex),
+			      sf::IntRect(x, y, static_cast<int>(imageSize.x),
+					  static_cast<int>(imageSize.y))};
+		placements.push_back({index, region});
+		this->usedArea += static_cast<unsigned long long>(imageSize.x) * imageSize.y;
+	}
+
+	// Pages are trimmed to what was used, so a half empty page costs half the memory.
+	for (const Page &layout : layouts) {
+		sf::Image image;
+		image.create(std::max(1, std::min(size, layout.usedWidth)),
+			     std::max(1, std::min(size, layout.usedHeight)),
+			     sf::Color::Transparent);
+		this->pageImages.push_back(image);
+	}
+
+	for (const auto &placement : placements) {
+		const Region &region = placement.second;
+		this->pageImages[region.page].copy(this->pending[placement.first].image,
+						   region.rect.left, region.rect.top);
+		this->regions[this->pending[placement.first].name] = region;
+	}
+
+	for (const sf::Image &image : this->pageImages) {
+		this->pages.push_back(sf::Texture());
+		this->pages.back().loadFromImage(image);
+	}
+
+	this->pending.clear();
+
+	std::ostringstream msg;
+	msg << "Texture atlas packed " << this->regions.size() << " images into "
+	    << this->pages.size() << " page(s), " << (getOccupancy() * 100.f) << "% occupied.";
+
+	dbg::printMessage(msg.str().c_str(), dbg::Urgency::DEFAULT);
+
+	return packedAll;
+}
+
+bool TextureAtlas::saveToFile(const std::string &basePath) const
+{
+	// Write every page as a png next to a plain text lookup table
+
+	boost::filesystem::path parent = boost::filesystem::path(basePath).parent_path();
+	if (!parent.empty()) {
+		boost::system::error_code ec;
+		boost::filesystem::create_directories(parent, ec);
+	}
+
+	std::ofstream lookup(basePath + ".atlas");
+	if (!lookup) {
+		return false;
+	}
+
+	lookup << "pages " << this->pageImages.size() << "\n";
+
+	for (const auto &entry : this->sources) {
+		lookup << "source " << entry.second.modified << " " << entry.second.size << " "
+		       << entry.first << "\n";
+	}
+
+	for (std::size_t i = 0; i < this->pageImages.size(); i++) {
+		std::ostringstream pagePath;
+		pagePath << basePath << "_" << i << ".png";
+
+		if (!this->pageImages[i].saveToFile(pagePath.str())) {
+			return false;
+		}
+	}
+
+	// The name goes last since it may contain spaces.
+	for (const auto &entry : this->regions) {
+		const Region &region = entry.second;
+
+		lookup << "region " << region.page << " " << region.rect.left << " "
+		       << region.rect.top << " " << region.rect.width << " "
+		       << region.rect.height << " " << entry.first << "\n";
+	}
+
+	return static_cast<bool>(lookup);
+}
+
+bool TextureAtlas::loadFromFile(const std::string &basePath)
+{
+	// Load pages and lookup table written by saveToFile
+
+	std::ifstream lookup(basePath + ".atlas");
+	if (!lookup) {
+		return false;
+	}
+
+	std::string keyword;
+	std::size_t pageCount = 0;
+
+	if (!(lookup >> keyword >> pageCount) || keyword != "pages") {
+		dbg::printMessage("Texture atlas lookup table is malformed.",
+				  dbg::Urgency::WARNING);
+		return false;
+	}
+
+	std::map<std::string, SourceStamp> loadedSources;
+	std::map<std::string, Region> loadedRegions;
+	unsigned long long area = 0;
+
+	while (lookup >> keyword) {
+		std::string name;
+
+		if (keyword == "source") {
+			SourceStamp cached;
+			SourceStamp current;
+
+			if (!(lookup >> cached.modified >> cached.size)) {
+				dbg::printMessage("Texture atlas lookup table is malformed.",
+						  dbg::Urgency::WARNING);
+				return false;
+			}
+
+			std::getline(lookup >> std::ws, name);
+
+			// An image changed since the atlas was packed, it has to be packed again.
+			if (!stampFile(name, current) || current.modified != cached.modified ||
+			    current.size != cached.size) {
+				std::ostringstream msg;
+				msg << "Texture atlas cache is older than \"" << name
+				    << "\", ignoring it.";
+
+				dbg::printMessage(msg.str().c_str(), dbg::Urgency::DEFAULT);
+				return false;
+			}
+
+			loadedSources[name] = cached;
+			continue;
+		}
+
+		Region region;
+		if (keyword != "region" ||
+		    !(lookup >> region.page >> region.rect.left >> region.rect.top >>
+		      region.rect.width >> region.rect.height) ||
+		    region.page >= pageCount) {
+			dbg::printMessage("Texture atlas lookup table is malformed.",
+					  dbg::Urgency::WARNING);
+			return false;
+		}
+
+		std::getline(lookup >> std::ws, name);
+
+		loadedRegions[name] = region;
+		area += static_cast<unsigned long long>(region.rect.width) * region.rect.height;
+	}
+
+	std::vector<sf::Image> images(pageCount);
+
+	for (std::size_t i = 0; i < pageCount; i++) {
+		std::ostringstream pagePath;
+		pagePath << basePath << "_" << i << ".png";
+
+		if (!images[i].loadFromFile(pagePath.str())) {
+			return false;
+		}
+	}
+
+	this->pending.clear();
+	this->pageImages = std::move(images);
+	this->regions = std::move(loadedRegions);
+	this->sources = std::move(loadedSources);
+	this->usedArea = area;
+
+	this->pages.clear();
+	for (const sf::Image &image : this->pageImages) {
+		this->pages.push_back(sf::Texture());
+		this->pages.back().loadFromImage(image);
+	}
+
+	return true;
+}
+
+const TextureAtlas::Region *TextureAtlas::find(const std::string &name) const
+{
+	auto it = this->regions.find(name);
+
+	if (it == this->regions.end()) {
+		return nullptr;
+	}
+
+	return &it->second;
+}
+
+const sf::Texture &TextureAtlas::getPage(unsigned int page) const
+{
+	return this->pages.at(page);
+}
+
+std::size_t TextureAtlas::getPageCount() const
+{
+	return this->pages.size();
+}
+
+float TextureAtlas::getOccupancy() const
+{
+	unsigned long long pageArea = 0;
+
+	for (const sf::Image &image : this->pageImages) {
+		pageArea += static_cast<unsigned long long>(image.getSize().x) * image.getSize().y;
+	}
+
+	if (pageArea == 0) {
+		return 0.f;
+	}
+
+	return static_cast<float>(this->usedArea) / static_cast<float>(pageArea);
+}
+
+bool TextureAtlas::stampFile(const std::string &filename, SourceStamp &stamp)
+{
+	boost::system::error_code ec;
+	std::time_t modified = boost::filesystem::last_write_time(filename, ec);
+
+	if (ec) {
+		return false;
+	}
+
+	std::uintmax_t size = boost::filesystem::file_size(filename, ec);
+
+	if (ec) {
+		return false;
+	}
+
+	stamp.modified = static_cast<long long>(modified);
+	stamp.size = static_cast<unsigned long long>(size);
+
+	return true;
+}
+
+int TextureAtlas::fitNode(const Page &page, std::size_t node, int width, int height) const
+{
+	// Returns the y a rect would rest at if placed on this node, or -1 if it doesn't fit
+
+	int size = static_cast<int>(page.skyline.back().x + page.skyline.back().width);
+	int x = page.skyline[node].x;
+
+	if (x + width > size) {
+		return -1;
+	}
+
+	int y = page.skyline[node].y;
+	int widthLeft = width;
+
+	for (std::size_t i = node; widthLeft > 0; i++) {
+		if (i >= page.skyline.size()) {
+			return -1;
+		}
+
+		y = std::max(y, page.skyline[i].y);
+
+		if (y + height > size) {
+			return -1;
+		}
+
+		widthLeft -= page.skyline[i].width;
+	}
+
+	return y;
+}
+
+bool TextureAtlas::findPosition(const Page &page, int width, int height, int &bestX,
+				int &bestY, std::size_t &bestNode) const
+{
+	// Bottom-left heuristic, the lowest resting edge wins and narrower nodes break ties
+
+	int bestBottom = -1;
+	int bestWidth = 0;
+
+	for (std::size_t i = 0; i < page.skyline.size(); i++) {
+		int y = fitNode(page, i, width, height);
+
+		if (y < 0) {
+			continue;
+		}
+
+		int bottom = y + height;
+
+		if (bestBottom < 0 || bottom < bestBottom ||
+		    (bottom == bestBottom && page.skyline[i].width < bestWidth)) {
+			bestBottom = bottom;
+			bestWidth = page.skyline[i].width;
+			bestX = page.skyline[i].x;
+			bestY = y;
+			bestNode = i;
+		}
+	}
+
+	return bestBottom >= 0;
+}
+
+void TextureAtlas::placeRect(Page &page, std::size_t node, int x, int y, int width, int height)
+{
+	std::vector<SkylineNode> &skyline = page.skyline;
+
+	skyline.insert(skyline.begin() + node, SkylineNode{x, y + height, width});
+
+	// Shrink or drop the nodes now covered by the new one.
+	for (std::size_t i = node + 1; i < skyline.size();) {
+		int previousEnd = skyline[i - 1].x + skyline[i - 1].width;
+
+		if (skyline[i].x >= previousEnd) {
+			break;
+		}
+
+		int shrink = previousEnd - skyline[i].x;
+		skyline[i].x += shrink;
+		skyline[i].width -= shrink;
+
+		if (skyline[i].width > 0) {
+			break;
+		}
+
+		skyline.erase(skyline.begin() + i);
+	}
+
+	// Merge neighbours at the same height.
+	for (std::size_t i = 0; i + 1 < skyline.size();) {
+		if (skyline[i].y == skyline[i + 1].y) {
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		} else {
+			i++;
+		}
+	}
+
+	page.usedWidth = std::max(page.usedWidth, x + width);
+	page.usedHeight = std::max(page.usedHeight, y + height);
+}
@@ -0,0 +1,83 @@
+#ifndef TEXTURE_ATLAS_HPP
+#define TEXTURE_ATLAS_HPP
+
+#include <SFML/Graphics.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+/* Packs many source images (or sub-rects of them) into a few large pages so that sprites and
+ * tiles from different sheets can be drawn without switching textures. Uses a skyline
+ * bottom-left packer, and the packed pages plus lookup table can be cached on disk. */
+class TextureAtlas
+{
+public:
+	struct Region {
+		unsigned int page;
+		sf::IntRect rect;
+	};
+
+	explicit TextureAtlas(unsigned int pageSize = 2048, unsigned int padding = 1);
+
+	bool addImage(const std::string &name, const std::string &filename);
+	void addImage(const std::string &name, const sf::Image &image,
+		      sf::IntRect area = sf::IntRect());
+
+	// Records the modification time and size of a file an image came from. Image files
+	// added by name are recorded already. loadFromFile refuses a cache whose sources changed.
+	void addSource(const std::string &filename);
+
+	bool pack();
+
+	bool saveToFile(const std::string &basePath) const;
+	bool loadFromFile(const std::string &basePath);
+
+	const Region *find(const std::string &name) const;
+	const sf::Texture &getPage(unsigned int page) const;
+	std::size_t getPageCount() const;
+
+	// Fraction of the page area covered by packed images.
+	float getOccupancy() const;
+
+private:
+	struct Pending {
+		std::string name;
+		sf::Image image;
+	};
+
+	struct SourceStamp {
+		long long modified;
+		unsigned long long size;
+	};
+
+	struct SkylineNode {
+		int x;
+		int y;
+		int width;
+	};
+
+	struct Page {
+		std::vector<SkylineNode> skyline;
+		int usedWidth;
+		int usedHeight;
+	};
+
+	bool findPosition(const Page &page, int width, int height, int &bestX, int &bestY,
+			  std::size_t &bestNode) const;
+	void placeRect(Page &page, std::size_t node, int x, int y, int width, int height);
+	int fitNode(const Page &page, std::size_t node, int width, int height) const;
+	static bool stampFile(const std::string &filename, SourceStamp &stamp);
+
+	unsigned int pageSize;
+	unsigned int padding;
+
+	std::vector<Pending> pending;
+	std::map<std::string, Region> regions;
+	std::map<std::string, SourceStamp> sources;
+
+	std::vector<sf::Image> pageImages;
+	std::vector<sf::Texture> pages;
+	unsigned long long usedArea;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* A few persistent worker threads for splitting a loop across cores. The calling thread works
+ * too, so a pool of 1 thread runs everything inline without any locking. */
+class ThreadPool
+{
+public:
+	explicit ThreadPool(unsigned int threads = 1)
+	{
+		resize(threads);
+	}
+
+	~ThreadPool()
+	{
+		stop();
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	// Total threads including the caller, at least 1.
+	void resize(unsigned int threads)
+	{
+		stop();
+
+		mStop = false;
+		for (unsigned int i = 1; i < threads; i++) {
+			mWorkers.emplace_back(&ThreadPool::workerLoop, this, i, mGeneration);
+		}
+	}
+
+	unsigned int getThreadCount() const
+	{
+		return static_cast<unsigned int>(mWorkers.size()) + 1;
+	}
+
+	// Calls task(index, thread) for every index below count, in any order and on any thread,
+	// and returns once all of them are done. thread is below getThreadCount().
+	void run(std::size_t count, const std::function<void(std::size_t, unsigned int)> &task)
+	{
+		if (mWorkers.empty() || count < 2) {
+			for (std::size_t i = 0; i < count; i++) {
+				task(i, 0);
+			}
+
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mTask = &task;
+			mCount = count;
+			mNext = 0;
+			mBusy = mWorkers.size();
+			mGeneration++;
+		}
+		mWake.notify_all();
+
+		work(0);
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		mDone.wait(lock, [this] { return mBusy == 0; });
+		mTask = nullptr;
+	}
+
+private:
+	void work(unsigned int thread)
+	{
+		for (std::size_t i = mNext++; i < mCount; i = mNext++) {
+			(*mTask)(i, thread);
+		}
+	}
+
+	// seen is the generation when the worker was created, so a worker added by resize() after
+	// a run() doesn't take that run for a new one. Reading it once the thread starts would
+	// miss a run() that got in first.
+	void workerLoop(unsigned int thread, std::size_t seen)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		while (true) {
+			mWake.wait(lock, [this, seen] { return mStop || mGeneration != seen; });
+
+			if (mStop) {
+				return;
+			}
+
+			seen = mGeneration;
+
+			lock.unlock();
+			work(thread);
+			lock.lock();
+
+			if (--mBusy == 0) {
+				mDone.notify_one();
+			}
+		}
+	}
+
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStop = true;
+		}
+		mWake.notify_all();
+
+		for (std::thread &worker : mWorkers) {
+			worker.join();
+		}
+
+		mWorkers.clear();
+	}
+
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	std::condition_variable mDone;
+
+	const std::function<void(std::size_t, unsigned int)> *mTask = nullptr;
+	std::size_t mCount = 0;
+	std::atomic<std::size_t> mNext{0};
+	std::size_t mBusy = 0;
+	std::size_t mGeneration = 0;
+	bool mStop = false;
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "chunk-streamer.hpp"
+
+#include <algorithm>
+
+tmx::ChunkStreamer::ChunkStreamer()
+{
+	this->worker = std::thread(&ChunkStreamer::run, this);
+}
+
+tmx::ChunkStreamer::~ChunkStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+
+	this->wake.notify_one();
+	this->worker.join();
+}
+
+void tmx::ChunkStreamer::request(std::vector<Request> &requests)
+{
+	std::stable_sort(
+	    requests.begin(), requests.end(),
+	    [](const Request &a, const Request &b) { return a.priority < b.priority; });
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->requests.clear();
+
+		for (const Request &request : requests) {
+			// Already on its way.
+			if (this->building && request.layer == this->current.layer &&
+			    request.chunk == this->current.chunk) {
+				continue;
+			}
+
+			this->requests.push_back(request);
+		}
+	}
+
+	this->wake.notify_one();
+}
+
+void tmx::ChunkStreamer::collect(std::vector<Result> &results)
+{
+	results.clear();
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	results.swap(this->results);
+}
+
+void tmx::ChunkStreamer::cancel()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	this->generation++;
+	this->requests.clear();
+	this->results.clear();
+
+	this->idle.wait(lock, [this]() { return !this->building; });
+}
+
+void tmx::ChunkStreamer::run()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	while (true) {
+		this->wake.wait(lock,
+				[this]() { return this->stopping || !this->requests.empty(); });
+
+		if (this->stopping) {
+			return;
+		}
+
+		this->current = this->requests.front();
+		this->requests.pop_front();
+		this->building = true;
+		unsigned int generation = this->generation;
+
+		// Building only reads the layer, which the main thread leaves alone until cancel.
+		lock.unlock();
+		Layer::LayerChunk built = this->current.layer->buildChunk(this->current.chunk);
+		lock.lock();
+
+		this->building = false;
+
+		if (generation == this->generation) {
+			this->results.push_back(Result{this->current.layerIndex,
+						       this->current.chunk, std::move(built)});
+		}
+
+		this->idle.notify_all();
+	}
+}
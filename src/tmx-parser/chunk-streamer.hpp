@@ -0,0 +1,69 @@
+#ifndef TMX_PARSER_CHUNK_STREAMER_HPP
+#define TMX_PARSER_CHUNK_STREAMER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "layer.hpp"
+
+namespace tmx
+{
+/* Builds layer chunks on one background thread. The map hands it the chunks it wants each
+ * frame and collects the finished ones on the main thread, stores into the layers only happen
+ * there. Chunks of infinite layers bring their decoded tiles along and take them when they're
+ * unloaded, so only the chunks around the view are ever decoded. */
+class ChunkStreamer
+{
+public:
+	struct Request {
+		const Layer *layer;
+		std::size_t layerIndex;
+		unsigned int chunk;
+		float priority; // Lower is built first.
+	};
+
+	struct Result {
+		std::size_t layerIndex;
+		unsigned int chunk;
+		Layer::LayerChunk built;
+	};
+
+	ChunkStreamer();
+	~ChunkStreamer();
+
+	ChunkStreamer(const ChunkStreamer &) = delete;
+	ChunkStreamer &operator=(const ChunkStreamer &) = delete;
+
+	// Replaces whatever is still queued, chunks the view moved away from are never built.
+	void request(std::vector<Request> &requests);
+
+	// Moves the finished chunks into results.
+	void collect(std::vector<Result> &results);
+
+	// Drops queued and finished chunks and waits for the one being built. The layers can be
+	// changed afterwards, nothing built from their old state is delivered.
+	void cancel();
+
+private:
+	void run();
+
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable idle;
+
+	std::deque<Request> requests;
+	std::vector<Result> results;
+
+	bool building = false;
+	Request current;
+	unsigned int generation = 0;
+	bool stopping = false;
+};
+} // namespace tmx
+
+#endif
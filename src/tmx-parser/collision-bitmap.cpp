@@ -0,0 +1,211 @@
+#include "collision-bitmap.hpp"
+#include "layer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void tmx::CollisionBitmap::build(const std::vector<Layer> &layers, unsigned int category,
+				 sf::Rect<unsigned int> cells, unsigned int tileWidth,
+				 unsigned int tileHeight)
+{
+	// Merge every blocking layer of the category into one bitmap
+
+	this->width = cells.width;
+	this->height = cells.height;
+	this->origin = sf::Vector2u(cells.left, cells.top);
+	this->tileWidth = static_cast<float>(std::max(1u, tileWidth));
+	this->tileHeight = static_cast<float>(std::max(1u, tileHeight));
+	this->wordsPerRow = (this->width + 63) / 64;
+
+	this->bits.assign(static_cast<std::size_t>(this->wordsPerRow) * this->height, 0);
+
+	for (const Layer &layer : layers) {
+		if (!layer.isBlocking || layer.collisionCategory != category) {
+			continue;
+		}
+
+		unsigned int rows = std::min(layer.height, cells.top + cells.height);
+		unsigned int cols = std::min(layer.width, cells.left + cells.width);
+
+		for (unsigned int row = cells.top; row < rows; row++) {
+			for (unsigned int col = cells.left; col < cols; col++) {
+				if (layer.hasTile(static_cast<int>(col), static_cast<int>(row))) {
+					set(col - cells.left, row - cells.top);
+				}
+			}
+		}
+	}
+}
+
+bool tmx::CollisionBitmap::isBlocked(int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= static_cast<int>(this->width) ||
+	    y >= static_cast<int>(this->height)) {
+		return false;
+	}
+
+	std::uint64_t word = this->bits[static_cast<std::size_t>(y) * this->wordsPerRow + x / 64];
+	return (word >> (x % 64)) & 1u;
+}
+
+bool tmx::CollisionBitmap::overlaps(const sf::Rect<float> &rect) const
+{
+	if (rect.width <= 0.f || rect.height <= 0.f || this->bits.empty()) {
+		return false;
+	}
+
+	// A cell is hit when it's strictly inside the rect's span, same as sf::Rect::intersects.
+	float left = rect.left - this->origin.x * this->tileWidth;
+	float top = rect.top - this->origin.y * this->tileHeight;
+
+	int minX = static_cast<int>(std::floor(left / this->tileWidth));
+	int minY = static_cast<int>(std::floor(top / this->tileHeight));
+	int maxX = static_cast<int>(std::ceil((left + rect.width) / this->tileWidth)) - 1;
+	int maxY = static_cast<int>(std::ceil((top + rect.height) / this->tileHeight)) - 1;
+
+	minX = std::max(minX, 0);
+	minY = std::max(minY, 0);
+	maxX = std::min(maxX, static_cast<int>(this->width) - 1);
+	maxY = std::min(maxY, static_cast<int>(this->height) - 1);
+
+	if (minX > maxX || minY > maxY) {
+		return false;
+	}
+
+	int firstWord = minX / 64;
+	int lastWord = maxX / 64;
+
+	for (int y = minY; y <= maxY; y++) {
+		const std::uint64_t *row =
+		    &this->bits[static_cast<std::size_t>(y) * this->wordsPerRow];
+
+		for (int word = firstWord; word <= lastWord; word++) {
+			std::uint64_t mask = ~std::uint64_t(0);
+
+			if (word == firstWord) {
+				mask &= ~std::uint64_t(0) << (minX % 64);
+			}
+
+			if (word == lastWord) {
+				mask &= ~std::uint64_t(0) >> (63 - maxX % 64);
+			}
+
+			if (row[word] & mask) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool tmx::CollisionBitmap::raycast(sf::Vector2f origin, sf::Vector2f direction, float maxDistance,
+				   float &distance, sf::Vector2f &normal) const
+{
+	// Grid traversal (Amanatides & Woo), one cell per step in whichever axis is closer
+
+	if (this->bits.empty() || maxDistance < 0.f) {
+		return false;
+	}
+
+	// Work in cells, t stays in pixels since both axes are scaled the same way as the ray.
+	float originX = origin.x / this->tileWidth - this->origin.x;
+	float originY = origin.y / this->tileHeight - this->origin.y;
+	float dirX = direction.x / this->tileWidth;
+	float dirY = direction.y / this->tileHeight;
+
+	int x = static_cast<int>(std::floor(originX));
+	int y = static_cast<int>(std::floor(originY));
+	int stepX = dirX > 0.f ? 1 : (dirX < 0.f ? -1 : 0);
+	int stepY = dirY > 0.f ? 1 : (dirY < 0.f ? -1 : 0);
+
+	float infinity = std::numeric_limits<float>::infinity();
+	float deltaX = stepX != 0 ? 1.f / std::abs(dirX) : infinity;
+	float deltaY = stepY != 0 ? 1.f / std::abs(dirY) : infinity;
+	float nextX = stepX > 0 ? (x + 1 - originX) * deltaX
+				: (stepX < 0 ? (originX - x) * deltaX : infinity);
+	float nextY = stepY > 0 ? (y + 1 - originY) * deltaY
+				: (stepY < 0 ? (originY - y) * deltaY : infinity);
+
+	int width = static_cast<int>(this->width);
+	int height = static_cast<int>(this->height);
+
+	float t = 0.f;
+	sf::Vector2f entered(0.f, 0.f);
+
+	while (t <= maxDistance) {
+		if (x >= 0 && y >= 0 && x < width && y < height) {
+			std::uint64_t word =
+			    this->bits[static_cast<std::size_t>(y) * this->wordsPerRow + x / 64];
+
+			if ((word >> (x % 64)) & 1u) {
+				distance = t;
+				normal = entered;
+				return true;
+			}
+		} else if ((x < 0 && stepX <= 0) || (y < 0 && stepY <= 0) ||
+			   (x >= width && stepX >= 0) || (y >= height && stepY >= 0)) {
+			// Outside the map and moving away from it.
+			return false;
+		}
+
+		if (nextX < nextY) {
+			t = nextX;
+			nextX += deltaX;
+			x += stepX;
+			entered = sf::Vector2f(static_cast<float>(-stepX), 0.f);
+		} else {
+			t = nextY;
+			nextY += deltaY;
+			y += stepY;
+			entered = sf::Vector2f(0.f, static_cast<float>(-stepY));
+		}
+	}
+
+	return false;
+}
+
+unsigned int tmx::CollisionBitmap::getWidth() const
+{
+	return this->width;
+}
+
+unsigned int tmx::CollisionBitmap::getHeight() const
+{
+	return this->height;
+}
+
+sf::Vector2u tmx::CollisionBitmap::getOrigin() const
+{
+	return this->origin;
+}
+
+const std::vector<std::uint64_t> &tmx::CollisionBitmap::getWords() const
+{
+	return this->bits;
+}
+
+sf::Vector2f tmx::CollisionBitmap::getTileSize() const
+{
+	return sf::Vector2f(this->tileWidth, this->tileHeight);
+}
+
+void tmx::CollisionBitmap::assign(unsigned int width, unsigned int height, sf::Vector2f tileSize,
+				  const std::uint64_t *words)
+{
+	this->width = width;
+	this->height = height;
+	this->origin = sf::Vector2u();
+	this->tileWidth = tileSize.x;
+	this->tileHeight = tileSize.y;
+	this->wordsPerRow = (width + 63) / 64;
+
+	this->bits.assign(words, words + static_cast<std::size_t>(this->wordsPerRow) * height);
+}
+
+void tmx::CollisionBitmap::set(unsigned int x, unsigned int y)
+{
+	this->bits[static_cast<std::size_t>(y) * this->wordsPerRow + x / 64] |=
+	    std::uint64_t(1) << (x % 64);
+}
@@ -0,0 +1,59 @@
+#ifndef TMX_PARSER_COLLISION_BITMAP_HPP
+#define TMX_PARSER_COLLISION_BITMAP_HPP
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace tmx
+{
+class Layer;
+
+/* One bit per map cell, set when any blocking layer of the category has a tile there. Rows
+ * are padded to a whole number of 64 bit words so a run of cells can be tested a word at a
+ * time. A bitmap can cover just part of the map, like one chunk of an infinite map. */
+class CollisionBitmap
+{
+public:
+	// Covers the cells in the rect, the queries below still take map pixels.
+	void build(const std::vector<Layer> &layers, unsigned int category,
+		   sf::Rect<unsigned int> cells, unsigned int tileWidth, unsigned int tileHeight);
+
+	// Relative to getOrigin().
+	bool isBlocked(int x, int y) const;
+
+	// True if the rect overlaps a blocked cell, touching edges don't count.
+	bool overlaps(const sf::Rect<float> &rect) const;
+
+	// Walks the cells along a ray in pixels, direction must be unit length. Returns the
+	// distance to the first blocked cell within maxDistance and the side it was entered from,
+	// a ray starting in a blocked cell hits at 0 with no normal.
+	bool raycast(sf::Vector2f origin, sf::Vector2f direction, float maxDistance,
+		     float &distance, sf::Vector2f &normal) const;
+
+	unsigned int getWidth() const;
+	unsigned int getHeight() const;
+	sf::Vector2u getOrigin() const;
+
+	// The raw rows, for caching. assign() takes words laid out the same way, for a bitmap
+	// starting at cell 0, 0.
+	const std::vector<std::uint64_t> &getWords() const;
+	sf::Vector2f getTileSize() const;
+	void assign(unsigned int width, unsigned int height, sf::Vector2f tileSize,
+		    const std::uint64_t *words);
+
+private:
+	void set(unsigned int x, unsigned int y);
+
+	unsigned int width = 0;
+	unsigned int height = 0;
+	sf::Vector2u origin;
+	float tileWidth = 1.f;
+	float tileHeight = 1.f;
+
+	unsigned int wordsPerRow = 0;
+	std::vector<std::uint64_t> bits;
+};
+} // namespace tmx
+
+#endif
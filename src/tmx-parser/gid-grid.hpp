@@ -0,0 +1,149 @@
+#ifndef TMX_PARSER_GID_GRID_HPP
+#define TMX_PARSER_GID_GRID_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace tmx
+{
+/* A layer's gids, row by row in one block, kept in 16 bits once compact() finds they all
+ * fit. Parsed layers own them, layers loaded from a map cache point straight into the mapped
+ * file and keep the mapping alive for as long as they need it. */
+class GidGrid
+{
+public:
+	int operator[](std::size_t index) const
+	{
+		if (this->narrow) {
+			return getNarrow()[index];
+		}
+
+		return getWide()[index];
+	}
+
+	std::size_t size() const
+	{
+		if (this->mapped) {
+			return this->mappedCount;
+		}
+
+		return this->narrow ? this->ownedNarrow.size() : this->ownedWide.size();
+	}
+
+	bool isNarrow() const
+	{
+		return this->narrow;
+	}
+
+	// The cells as stored, getCellSize() bytes each.
+	const void *getCells() const
+	{
+		if (this->narrow) {
+			return getNarrow();
+		}
+
+		return getWide();
+	}
+
+	std::size_t getCellSize() const
+	{
+		return this->narrow ? sizeof(std::uint16_t) : sizeof(int);
+	}
+
+	std::size_t getBytes() const
+	{
+		return size() * getCellSize();
+	}
+
+	// Parsing appends full width gids, compact() narrows them afterwards.
+	void reserve(std::size_t count)
+	{
+		this->ownedWide.reserve(count);
+	}
+
+	void push_back(int gid)
+	{
+		this->ownedWide.push_back(gid);
+	}
+
+	void assign(std::vector<int> gids)
+	{
+		clear();
+
+		this->ownedWide = std::move(gids);
+	}
+
+	// Switches to 16 bit cells if every gid fits.
+	void compact()
+	{
+		if (this->narrow || this->mapped) {
+			return;
+		}
+
+		bool fits = std::all_of(this->ownedWide.begin(), this->ownedWide.end(),
+					[](int gid) { return gid >= 0 && gid <= UINT16_MAX; });
+
+		if (!fits) {
+			return;
+		}
+
+		this->ownedNarrow.assign(this->ownedWide.begin(), this->ownedWide.end());
+		std::vector<int>().swap(this->ownedWide);
+		this->narrow = true;
+	}
+
+	void clear()
+	{
+		std::vector<int>().swap(this->ownedWide);
+		std::vector<std::uint16_t>().swap(this->ownedNarrow);
+		this->narrow = false;
+		this->mapped = nullptr;
+		this->mappedCount = 0;
+		this->mapping.reset();
+	}
+
+	// Use cells that live in a mapping, nothing is copied.
+	void assignMapped(const void *cells, std::size_t count, bool narrow,
+			  std::shared_ptr<const void> mapping)
+	{
+		clear();
+
+		this->narrow = narrow;
+		this->mapped = cells;
+		this->mappedCount = count;
+		this->mapping = std::move(mapping);
+	}
+
+private:
+	const std::uint16_t *getNarrow() const
+	{
+		if (this->mapped) {
+			return static_cast<const std::uint16_t *>(this->mapped);
+		}
+
+		return this->ownedNarrow.data();
+	}
+
+	const int *getWide() const
+	{
+		if (this->mapped) {
+			return static_cast<const int *>(this->mapped);
+		}
+
+		return this->ownedWide.data();
+	}
+
+	std::vector<int> ownedWide;
+	std::vector<std::uint16_t> ownedNarrow;
+	bool narrow = false;
+
+	const void *mapped = nullptr;
+	std::size_t mappedCount = 0;
+	std::shared_ptr<const void> mapping;
+};
+} // namespace tmx
+
+#endif
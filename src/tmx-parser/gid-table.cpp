@@ -0,0 +1,38 @@
+#include "gid-table.hpp"
+
+#include <algorithm>
+
+void tmx::GidTable::build(const std::vector<Tileset> &tilesets)
+{
+	// Tilesets cover consecutive gids starting at their first gid, later ones win overlaps
+
+	int gidCount = 1;
+
+	for (const Tileset &tileset : tilesets) {
+		gidCount = std::max(gidCount,
+				    tileset.firstGid + static_cast<int>(tileset.tileCount));
+	}
+
+	this->entries.assign(gidCount, this->empty);
+
+	for (unsigned int index = 0; index < tilesets.size(); index++) {
+		const Tileset &tileset = tilesets[index];
+
+		for (int localId = 0; localId < static_cast<int>(tileset.tileCount); localId++) {
+			int gid = tileset.firstGid + localId;
+
+			if (gid <= 0) {
+				continue;
+			}
+
+			this->entries[gid] = Entry{
+			    &tileset,
+			    index,
+			    localId,
+			    tileset.getAnimation(localId),
+			    tileset.getTextureRect(localId),
+			    &tileset.getTexture(),
+			};
+		}
+	}
+}
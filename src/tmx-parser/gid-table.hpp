@@ -0,0 +1,49 @@
+#ifndef TMX_PARSER_GID_TABLE_HPP
+#define TMX_PARSER_GID_TABLE_HPP
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+#include "tileset.hpp"
+
+namespace tmx
+{
+/* Every gid of a map resolved up front to its tileset, its id inside the tileset and where it
+ * is on the texture, so drawing and collision find any tile with one index. Built once the
+ * tilesets are loaded and again when they move into an atlas. */
+class GidTable
+{
+public:
+	struct Entry {
+		const Tileset *tileset; // nullptr for gid 0 and gids no tileset covers.
+		unsigned int tilesetIndex;
+		int localId;
+		int animation; // Index into the tileset's animations, -1 for static tiles.
+		sf::IntRect textureRect;
+		const sf::Texture *texture;
+	};
+
+	// The tileset entries point into tilesets, which has to outlive the table.
+	void build(const std::vector<Tileset> &tilesets);
+
+	const Entry &operator[](int gid) const
+	{
+		if (gid < 0 || gid >= static_cast<int>(this->entries.size())) {
+			return this->empty;
+		}
+
+		return this->entries[gid];
+	}
+
+	bool hasTile(int gid) const
+	{
+		return (*this)[gid].tileset != nullptr;
+	}
+
+private:
+	std::vector<Entry> entries;
+	Entry empty{nullptr, 0, 0, -1, sf::IntRect(), nullptr};
+};
+} // namespace tmx
+
+#endif
@@ -0,0 +1,191 @@
+#include "layer-data.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <zlib.h>
+
+namespace
+{
+const std::uint8_t BASE64_SKIP = 0xFE;
+const std::uint8_t BASE64_INVALID = 0xFF;
+
+std::array<std::uint8_t, 256> makeBase64Table()
+{
+	std::array<std::uint8_t, 256> table;
+	table.fill(BASE64_INVALID);
+
+	const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	for (std::uint8_t i = 0; i < 64; i++) {
+		table[static_cast<unsigned char>(alphabet[i])] = i;
+	}
+
+	table[' '] = BASE64_SKIP;
+	table['\t'] = BASE64_SKIP;
+	table['\n'] = BASE64_SKIP;
+	table['\r'] = BASE64_SKIP;
+	table['='] = BASE64_SKIP;
+
+	return table;
+}
+} // namespace
+
+bool tmx::decodeBase64(const char *text, std::vector<std::uint8_t> &bytes)
+{
+	return decodeBase64(text, std::strlen(text), bytes);
+}
+
+bool tmx::decodeBase64(const char *text, std::size_t length, std::vector<std::uint8_t> &bytes)
+{
+	// Four characters at a time while there are four in a row, one at a time around
+	// whitespace and at the end
+
+	static const std::array<std::uint8_t, 256> table = makeBase64Table();
+
+	const unsigned char *in = reinterpret_cast<const unsigned char *>(text);
+
+	bytes.clear();
+	bytes.reserve(length / 4 * 3 + 3);
+
+	std::uint32_t buffer = 0;
+	int bits = 0;
+
+	for (std::size_t i = 0; i < length;) {
+		if (bits == 0 && i + 4 <= length) {
+			std::uint32_t a = table[in[i]];
+			std::uint32_t b = table[in[i + 1]];
+			std::uint32_t c = table[in[i + 2]];
+			std::uint32_t d = table[in[i + 3]];
+
+			// Any of the four being whitespace, padding or invalid sets a high bit.
+			if (((a | b | c | d) & 0xC0) == 0) {
+				std::uint32_t word = (a << 18) | (b << 12) | (c << 6) | d;
+
+				bytes.push_back(static_cast<std::uint8_t>(word >> 16));
+				bytes.push_back(static_cast<std::uint8_t>(word >> 8));
+				bytes.push_back(static_cast<std::uint8_t>(word));
+
+				i += 4;
+				continue;
+			}
+		}
+
+		std::uint8_t value = table[in[i++]];
+
+		if (value == BASE64_SKIP) {
+			continue;
+		}
+
+		if (value == BASE64_INVALID) {
+			return false;
+		}
+
+		buffer = (buffer << 6) | value;
+		bits += 6;
+
+		if (bits >= 8) {
+			bits -= 8;
+			bytes.push_back(static_cast<std::uint8_t>(buffer >> bits));
+		}
+	}
+
+	return true;
+}
+
+bool tmx::decompress(const std::vector<std::uint8_t> &compressed, std::size_t expectedSize,
+		     std::vector<std::uint8_t> &bytes)
+{
+	z_stream stream;
+	std::memset(&stream, 0, sizeof(stream));
+
+	// 15 is the largest window, adding 32 lets zlib detect a gzip or zlib header itself.
+	if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+		return false;
+	}
+
+	// A little slack lets zlib reach the end of the stream without growing the buffer.
+	bytes.resize((expectedSize > 0 ? expectedSize : compressed.size() * 4) + 64);
+
+	stream.next_in = const_cast<Bytef *>(compressed.data());
+	stream.avail_in = static_cast<uInt>(compressed.size());
+
+	int result = Z_OK;
+
+	while (result == Z_OK) {
+		if (stream.total_out == bytes.size()) {
+			bytes.resize(bytes.size() * 2);
+		}
+
+		stream.next_out = bytes.data() + stream.total_out;
+		stream.avail_out = static_cast<uInt>(bytes.size() - stream.total_out);
+
+		result = inflate(&stream, Z_NO_FLUSH);
+	}
+
+	bytes.resize(stream.total_out);
+	inflateEnd(&stream);
+
+	return result == Z_STREAM_END;
+}
+
+bool tmx::stripChunkData(const char *text, std::size_t size, std::string &stripped)
+{
+	// Only the text between <chunk ...> and </chunk> is moved out, chunks holding <tile>
+	// elements and anything else are copied as they are
+
+	static const char openTag[] = "<chunk";
+	static const char closeTag[] = "</chunk>";
+
+	const char *end = text + size;
+	const char *copied = text;
+	const char *pos = text;
+	std::string result;
+
+	while (true) {
+		pos = std::search(pos, end, openTag, openTag + sizeof(openTag) - 1);
+
+		if (pos == end) {
+			break;
+		}
+
+		const char *name = pos + sizeof(openTag) - 1;
+		const char *tagEnd = std::find(name, end, '>');
+
+		if (tagEnd == end) {
+			break;
+		}
+
+		pos = tagEnd;
+
+		// <chunks>, or an empty <chunk/>.
+		if (!std::isspace(static_cast<unsigned char>(*name)) || tagEnd[-1] == '/') {
+			continue;
+		}
+
+		const char *payload = tagEnd + 1;
+		const char *payloadEnd = std::find(payload, end, '<');
+
+		if (static_cast<std::size_t>(end - payloadEnd) < sizeof(closeTag) - 1 ||
+		    std::memcmp(payloadEnd, closeTag, sizeof(closeTag) - 1) != 0) {
+			continue;
+		}
+
+		result.append(copied, name);
+		result += " offset=\"" + std::to_string(payload - text) + "\" length=\"" +
+			  std::to_string(payloadEnd - payload) + "\"";
+		result.append(name, payload);
+
+		copied = payloadEnd;
+		pos = payloadEnd;
+	}
+
+	if (copied == text) {
+		return false;
+	}
+
+	result.append(copied, end);
+	stripped.swap(result);
+
+	return true;
+}
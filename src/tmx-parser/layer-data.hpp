@@ -0,0 +1,29 @@
+#ifndef TMX_PARSER_LAYER_DATA_HPP
+#define TMX_PARSER_LAYER_DATA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tmx
+{
+// Top bits of a gid, Tiled uses them for flipping and rotating tiles.
+const std::uint32_t GID_FLAGS = 0xF0000000;
+
+// Decodes base64 text, whitespace (Tiled indents the data) is skipped. Replaces bytes.
+bool decodeBase64(const char *text, std::vector<std::uint8_t> &bytes);
+bool decodeBase64(const char *text, std::size_t length, std::vector<std::uint8_t> &bytes);
+
+// Inflates zlib or gzip data, the format is detected from the header. expectedSize is only a
+// hint for the first allocation. Replaces bytes.
+bool decompress(const std::vector<std::uint8_t> &compressed, std::size_t expectedSize,
+		std::vector<std::uint8_t> &bytes);
+
+// Copies a map's xml without the text of its <chunk> elements, each chunk gets offset and
+// length attributes saying where its text is in the original instead. Returns false and
+// leaves stripped alone when there are no chunks.
+bool stripChunkData(const char *text, std::size_t size, std::string &stripped);
+} // namespace tmx
+
+#endif
@@ -1,6 +1,11 @@
 #include "layer.hpp"
+#include "layer-data.hpp"
 
-tmx::Layer::Layer(tinyxml2::XMLElement *layerElement)
+#include <charconv>
+#include <cstring>
+
+tmx::Layer::Layer(tinyxml2::XMLElement *layerElement, std::shared_ptr<const char> source,
+		  std::size_t sourceSize)
 {
 	tinyxml2::XMLElement *data = layerElement->FirstChildElement("data");
 	tinyxml2::XMLElement *properties = layerElement->FirstChildElement("properties");
@@ -36,7 +41,7 @@ tmx::Layer::Layer(tinyxml2::XMLElement *layerElement)
 		dbg::printMessage(errMsg.str().c_str(), dbg::Urgency::WARNING);
 	}
 
-	if (!data || !data->GetText()) {
+	if (!data || (!data->GetText() && !data->FirstChildElement("chunk"))) {
 		std::ostringstream errMsg;
 		errMsg << "TMX Parser layer \"" << this->name
 		       << "\" has no data, stopping layer parsing.";
@@ -80,26 +85,94 @@ tmx::Layer::Layer(tinyxml2::XMLElement *layerElement)
 	if (properties != nullptr) {
 		tinyxml2::XMLElement *pListElement = properties->FirstChildElement("property");
 
-		std::string propName =
-		    pListElement->Attribute("name") ? pListElement->Attribute("name") : "";
+		while (pListElement != nullptr) {
+			std::string propName =
+			    pListElement->Attribute("name") ? pListElement->Attribute("name") : "";
+
+			if (propName.compare("isBlocking") == 0) {
+				pListElement->QueryBoolAttribute("value", &isBlocking);
+			}
+
+			if (propName.compare("isOverlay") == 0) {
+				pListElement->QueryBoolAttribute("value", &isOverlay);
+			}
 
-		if (propName.compare("isBlocking") == 0) {
-			pListElement->QueryBoolAttribute("value", &isBlocking);
+			if (propName.compare("collisionCategory") == 0) {
+				pListElement->QueryUnsignedAttribute("value", &collisionCategory);
+			}
+
+			pListElement = pListElement->NextSiblingElement("property");
 		}
+	}
+
+	tinyxml2::XMLElement *chunk = data->FirstChildElement("chunk");
 
-		if (propName.compare("isOverlay") == 0) {
-			pListElement->QueryBoolAttribute("value", &isOverlay);
+	if (chunk == nullptr) {
+		const char *text = data->GetText();
+		Tiles tiles;
+
+		if (parseData(text, text + std::strlen(text),
+			      static_cast<std::size_t>(this->width) * this->height, tiles)) {
+			this->data.assign(std::move(tiles.gids));
+			this->flips.swap(tiles.flips);
 		}
+
+		return;
 	}
 
+	// The chunks' text was left in the map file, only where it is gets recorded here.
+	this->infinite = true;
+
+	while (chunk != nullptr) {
+		sf::IntRect rect;
+		chunk->QueryIntAttribute("x", &rect.left);
+		chunk->QueryIntAttribute("y", &rect.top);
+		chunk->QueryIntAttribute("width", &rect.width);
+		chunk->QueryIntAttribute("height", &rect.height);
+
+		// Added by tmx::stripChunkData.
+		std::int64_t offset = -1;
+		std::int64_t length = -1;
+		chunk->QueryInt64Attribute("offset", &offset);
+		chunk->QueryInt64Attribute("length", &length);
+
+		if (!source || rect.width <= 0 || rect.height <= 0 || offset < 0 || length < 0 ||
+		    static_cast<std::size_t>(offset + length) > sourceSize) {
+			std::ostringstream errMsg;
+			errMsg << "TMX Parser layer \"" << this->name << "\" has a bad chunk at "
+			       << rect.left << ", " << rect.top << ", leaving layer.";
+
+			dbg::printMessage(errMsg.str().c_str(), dbg::Urgency::ERROR);
+			this->sourceChunks.clear();
+			return;
+		}
+
+		this->sourceChunks.push_back(SourceChunk{rect, static_cast<std::size_t>(offset),
+							 static_cast<std::size_t>(length)});
+
+		chunk = chunk->NextSiblingElement("chunk");
+	}
+
+	this->source = std::move(source);
+
+	sf::IntRect bounds = getSourceBounds();
+	this->width = static_cast<unsigned int>(bounds.width);
+	this->height = static_cast<unsigned int>(bounds.height);
+}
+
+bool tmx::Layer::parseData(const char *text, const char *end, std::size_t count,
+			   Tiles &tiles) const
+{
 	switch (this->encoding) {
 		case tmx::Encoding::CSV: {
-			std::string dataText = data->GetText();
-			std::replace(dataText.begin(), dataText.end(), ',', ' ');
+			if (!parseCsvData(text, end, count, tiles)) {
+				std::ostringstream errMsg;
+				errMsg << "TMX Parser layer \"" << this->name
+				       << "\" has corrupt csv data, leaving layer.";
 
-			std::stringstream ss(dataText);
-			std::copy(std::istream_iterator<int>(ss), std::istream_iterator<int>(),
-				  std::back_inserter(this->data));
+				dbg::printMessage(errMsg.str().c_str(), dbg::Urgency::ERROR);
+				return false;
+			}
 
 			break;
 		}
@@ -107,239 +180,741 @@ tmx::Layer::Layer(tinyxml2::XMLElement *layerElement)
 		case tmx::Encoding::XML: {
 			dbg::printMessage("XML parsing is not implemented yet!",
 					  dbg::Urgency::ERROR);
-			return;
+			return false;
 		}
 
-		case tmx::Encoding::BASE64_UNCOMPRESSED: {
-			dbg::printMessage("Uncompressed Base64 parsing is not implemented yet!",
-					  dbg::Urgency::ERROR);
-			return;
-		}
+		case tmx::Encoding::BASE64_UNCOMPRESSED:
+		case tmx::Encoding::BASE64_GZIP_COMPRESSED:
+		case tmx::Encoding::BASE64_ZLIB_COMPRESSED: {
+			bool compressed = this->encoding != tmx::Encoding::BASE64_UNCOMPRESSED;
 
-		case tmx::Encoding::BASE64_GZIP_COMPRESSED: {
-			dbg::printMessage("GZIP Compressed Base64 parsing is not implemented yet!",
-					  dbg::Urgency::ERROR);
-			return;
-		}
+			if (!decodeBase64Data(text, end, count, compressed, tiles)) {
+				std::ostringstream errMsg;
+				errMsg << "TMX Parser layer \"" << this->name
+				       << "\" has corrupt base64 data, leaving layer.";
 
-		case tmx::Encoding::BASE64_ZLIB_COMPRESSED: {
-			dbg::printMessage("ZLIB Compressed Base64 parsing is not implemented yet!",
-					  dbg::Urgency::ERROR);
-			return;
+				dbg::printMessage(errMsg.str().c_str(), dbg::Urgency::ERROR);
+				return false;
+			}
+
+			break;
 		}
 
 		default: {
 			dbg::printMessage("Unsupported compression method, leaving layer.",
 					  dbg::Urgency::ERROR);
-			return;
+			return false;
 		}
 	}
+
+	return true;
 }
 
-/* This is called after the sprite gets set. */
-void tmx::Layer::init()
+void tmx::Layer::appendGid(std::uint32_t gid, Tiles &tiles)
 {
-	int iw = static_cast<int>(this->width); // Int Width
-	int fGid = this->tileset.firstGid;
-	int dataSize = this->data.size();
-	sf::RectangleShape rect(sf::Vector2f(32.f, 32.f));
+	// Split the flag bits off, the flips are only stored once a tile uses them
+
+	std::uint8_t tileFlips = static_cast<std::uint8_t>((gid >> 29) & 0x7);
 
-	int dataPos;
+	if (tileFlips != 0 && tiles.flips.empty()) {
+		tiles.flips.assign(tiles.gids.size(), 0);
+	}
 
-	// Assign the data to the maptiles vector
-	for (unsigned int x = 0; x < this->width; x++) {
-		std::vector<MapTile> maptile;
+	if (!tiles.flips.empty()) {
+		tiles.flips.push_back(tileFlips);
+	}
 
-		for (unsigned int y = 0; y < this->height; y++) {
-			dataPos = x * iw + y;
+	tiles.gids.push_back(static_cast<int>(gid & ~tmx::GID_FLAGS));
+}
 
-			if (dataSize <= dataPos || (this->data[dataPos] - fGid) < 0) {
-				continue;
+bool tmx::Layer::parseCsvData(const char *text, const char *end, std::size_t count,
+			      Tiles &tiles) const
+{
+	// One pass over the xml text, gids are read unsigned since flipped tiles set the top bit
+
+	std::size_t firstTile = tiles.gids.size();
+
+	tiles.gids.reserve(firstTile + count);
+
+	while (text != end) {
+		char c = *text;
+
+		if (c == ',' || c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+			text++;
+			continue;
+		}
+
+		std::uint32_t gid;
+		std::from_chars_result result = std::from_chars(text, end, gid);
+
+		if (result.ec != std::errc()) {
+			return false;
+		}
+
+		appendGid(gid, tiles);
+		text = result.ptr;
+	}
+
+	if (tiles.gids.size() - firstTile != count) {
+		std::ostringstream errMsg;
+		errMsg << "TMX Parser layer \"" << this->name << "\" has "
+		       << tiles.gids.size() - firstTile << " tiles, expected " << count << ".";
+
+		dbg::printMessage(errMsg.str().c_str(), dbg::Urgency::WARNING);
+	}
+
+	return true;
+}
+
+bool tmx::Layer::decodeBase64Data(const char *text, const char *end, std::size_t count,
+				  bool compressed, Tiles &tiles) const
+{
+	// Base64 (optionally zlib or gzip compressed) array of little endian 32 bit gids
+
+	std::size_t expectedSize = count * 4;
+	std::vector<std::uint8_t> bytes;
+
+	if (!tmx::decodeBase64(text, static_cast<std::size_t>(end - text), bytes)) {
+		return false;
+	}
+
+	if (compressed) {
+		std::vector<std::uint8_t> inflated;
+
+		if (!tmx::decompress(bytes, expectedSize, inflated)) {
+			return false;
+		}
+
+		bytes.swap(inflated);
+	}
+
+	if (bytes.size() != expectedSize) {
+		std::ostringstream errMsg;
+		errMsg << "TMX Parser layer \"" << this->name << "\" has " << bytes.size() / 4
+		       << " tiles, expected " << count << ".";
+
+		dbg::printMessage(errMsg.str().c_str(), dbg::Urgency::WARNING);
+	}
+
+	tiles.gids.reserve(tiles.gids.size() + bytes.size() / 4);
+
+	for (std::size_t i = 0; i + 4 <= bytes.size(); i += 4) {
+		appendGid(static_cast<std::uint32_t>(bytes[i]) |
+			      static_cast<std::uint32_t>(bytes[i + 1]) << 8 |
+			      static_cast<std::uint32_t>(bytes[i + 2]) << 16 |
+			      static_cast<std::uint32_t>(bytes[i + 3]) << 24,
+			  tiles);
+	}
+
+	return true;
+}
+
+std::uint8_t tmx::Layer::getFlips(int dataPos) const
+{
+	return this->flips.empty() ? 0 : this->flips[dataPos];
+}
+
+sf::IntRect tmx::Layer::getSourceBounds() const
+{
+	if (this->sourceChunks.empty()) {
+		return sf::IntRect();
+	}
+
+	int left = std::numeric_limits<int>::max();
+	int top = std::numeric_limits<int>::max();
+	int right = std::numeric_limits<int>::min();
+	int bottom = std::numeric_limits<int>::min();
+
+	for (const SourceChunk &sourceChunk : this->sourceChunks) {
+		const sf::IntRect &rect = sourceChunk.rect;
+		left = std::min(left, rect.left);
+		top = std::min(top, rect.top);
+		right = std::max(right, rect.left + rect.width);
+		bottom = std::max(bottom, rect.top + rect.height);
+	}
+
+	return sf::IntRect(left, top, right - left, bottom - top);
+}
+
+void tmx::Layer::placeChunks(sf::Vector2i origin, unsigned int width, unsigned int height)
+{
+	// Only the chunks' rects move, nothing is decoded. Each chunk index remembers the source
+	// chunks covering it, Tiled's chunks don't have to line up with ours.
+
+	int size = static_cast<int>(CHUNK_SIZE);
+	unsigned int chunksX = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+	this->chunkSources.clear();
+
+	for (std::size_t i = 0; i < this->sourceChunks.size(); i++) {
+		sf::IntRect &rect = this->sourceChunks[i].rect;
+		rect.left -= origin.x;
+		rect.top -= origin.y;
+
+		int firstX = rect.left / size;
+		int firstY = rect.top / size;
+		int lastX = (rect.left + rect.width - 1) / size;
+		int lastY = (rect.top + rect.height - 1) / size;
+
+		for (int y = firstY; y <= lastY; y++) {
+			for (int x = firstX; x <= lastX; x++) {
+				this->chunkSources[y * chunksX + x].push_back(
+				    static_cast<std::uint32_t>(i));
 			}
+		}
+	}
 
-			maptile.push_back(MapTile{
-			    .x = y * this->tileset.tileWidth,
-			    .y = x * this->tileset.tileHeight,
-			    .isBlocking = isBlocking,
-			});
+	this->width = width;
+	this->height = height;
+}
+
+/* This is called after the map hands over its gid table and cell size. */
+void tmx::Layer::init()
+{
+	std::ostringstream msg;
+
+	if (this->infinite) {
+		msg << "Layer \"" << this->name << "\" streams " << this->sourceChunks.size()
+		    << " chunk(s) from the map file over " << this->width << "x" << this->height
+		    << " tiles.";
+	} else {
+		// Tile positions follow from the index and blocking from the layer, only the gids
+		// are kept, in 16 bits where they fit.
+		this->data.compact();
+
+		// The tile list this replaced kept 4 byte gids, a 12 byte MapTile per tile and a
+		// vector per row.
+		std::size_t tileCount = 0;
+		for (std::size_t i = 0; i < this->data.size(); i++) {
+			tileCount += this->data[i] != 0 ? 1 : 0;
 		}
 
-		tiles.push_back(maptile);
+		std::size_t listBytes = this->data.size() * sizeof(int) + tileCount * 12 +
+					this->height * sizeof(std::vector<int>);
+
+		msg << "Layer \"" << this->name << "\" keeps " << this->width << "x"
+		    << this->height << " tiles in " << this->data.getBytes() + this->flips.size()
+		    << " bytes (" << this->data.getCellSize() * 8
+		    << " bit gids), the tile list took " << listBytes << ".";
+	}
+
+	dbg::printMessage(msg.str().c_str(), dbg::Urgency::DEFAULT);
+
+	buildChunks();
+}
+
+void tmx::Layer::buildChunks()
+{
+	// The collision of every chunk an infinite layer drops has to go too.
+	if (this->infinite && this->isBlocking) {
+		this->changedChunks.insert(this->changedChunks.end(), this->residentChunks.begin(),
+					   this->residentChunks.end());
+	}
+
+	// Bake the chunks' quads once, drawing then only copies the visible chunks.
+	this->chunksX = (this->width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	this->chunksY = (this->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	this->chunks.clear();
+	this->residentChunks.clear();
+	this->residentBytes = 0;
+
+	// Streamed chunks are built around the view as it moves.
+	if (this->streamed) {
+		return;
+	}
+
+	for (unsigned int index = 0; index < this->chunksX * this->chunksY; index++) {
+		storeChunk(index, buildChunk(index));
 	}
 }
 
-void tmx::Layer::draw(sf::RenderWindow &window, sf::Time deltaTime)
+tmx::Layer::LayerChunk tmx::Layer::buildChunk(unsigned int index) const
 {
-	for (unsigned int x = 0; x < this->width; x++) {
-		for (unsigned int y = 0; y < this->height; y++) {
-			if ((this->data[x * this->width + y] - this->tileset.firstGid) < 0) {
+	LayerChunk chunk;
+
+	if (this->infinite) {
+		decodeChunk(index, chunk.tiles);
+	}
+
+	int firstCol = (index % this->chunksX) * CHUNK_SIZE;
+	int firstRow = (index / this->chunksX) * CHUNK_SIZE;
+	int lastCol = std::min(firstCol + static_cast<int>(CHUNK_SIZE),
+			       static_cast<int>(this->width));
+	int lastRow = std::min(firstRow + static_cast<int>(CHUNK_SIZE),
+			       static_cast<int>(this->height));
+
+	for (int row = firstRow; row < lastRow; row++) {
+		for (int col = firstCol; col < lastCol; col++) {
+			std::uint8_t tileFlips;
+			int gid = getGid(col, row, tileFlips, &chunk);
+			const GidTable::Entry &entry = (*this->gidTable)[gid];
+
+			if (!entry.tileset) {
 				continue;
 			}
 
-			this->sprite.setTextureRect(entityPosToTextureRect(x, y));
-			// clang-format off
-			this->sprite.setPosition(
-				(y * this->tileset.tileWidth),
-				(x * this->tileset.tileHeight)
-			);
-			// clang-format on
+			// Chunks rarely mix more than a couple of textures, searching is enough.
+			auto batch = std::find_if(chunk.batches.begin(), chunk.batches.end(),
+						  [&entry](const Batch &batch) {
+							  return batch.texture == entry.texture;
+						  });
+
+			if (batch == chunk.batches.end()) {
+				chunk.batches.push_back(Batch{entry.texture, {}});
+				batch = chunk.batches.end() - 1;
+			}
 
-			window.draw(this->sprite);
+			if (entry.animation >= 0) {
+				chunk.animatedTiles.push_back(AnimatedTile{
+				    static_cast<std::size_t>(batch - chunk.batches.begin()),
+				    batch->vertices.size(), gid,
+				    static_cast<unsigned int>(entry.localId), tileFlips});
+			}
+
+			render::appendQuad(batch->vertices,
+					   render::Item{
+					       .depth = 0.f,
+					       .bounds = getTileBounds(col, row, entry.textureRect),
+					       .textureRect = entry.textureRect,
+					       .texture = entry.texture,
+					       .color = sf::Color::White,
+					       .flips = tileFlips,
+					   });
 		}
 	}
+
+	return chunk;
 }
 
-void tmx::Layer::drawPosition(sf::RenderWindow &window, sf::Time deltaTime,
-			      const Transform &entityPos)
+void tmx::Layer::decodeChunk(unsigned int index, Tiles &tiles) const
 {
-	if (!this->isOverlay) {
+	// Decode every source chunk covering the chunk and copy the part that overlaps it
+
+	std::size_t cellCount = static_cast<std::size_t>(CHUNK_SIZE) * CHUNK_SIZE;
+	tiles.gids.assign(cellCount, 0);
+	tiles.flips.clear();
+
+	auto found = this->chunkSources.find(index);
+
+	if (found == this->chunkSources.end()) {
 		return;
 	}
 
-	int entityXPos =
-	    static_cast<int>(std::floor(entityPos.position.x) / this->tileset.tileWidth);
-	int entityYPos =
-	    static_cast<int>(std::floor(entityPos.position.y) / this->tileset.tileHeight);
+	int size = static_cast<int>(CHUNK_SIZE);
+	int firstCol = static_cast<int>(index % this->chunksX) * size;
+	int firstRow = static_cast<int>(index / this->chunksX) * size;
+	Tiles decoded;
+
+	for (std::uint32_t sourceIndex : found->second) {
+		const SourceChunk &sourceChunk = this->sourceChunks[sourceIndex];
+		const sf::IntRect &rect = sourceChunk.rect;
+		const char *text = this->source.get() + sourceChunk.offset;
+		std::size_t count = static_cast<std::size_t>(rect.width) * rect.height;
+
+		decoded.gids.clear();
+		decoded.flips.clear();
+
+		if (!parseData(text, text + sourceChunk.length, count, decoded) ||
+		    decoded.gids.size() != count) {
+			std::ostringstream errMsg;
+			errMsg << "TMX Parser layer \"" << this->name
+			       << "\" has a bad chunk at tile " << rect.left << ", " << rect.top
+			       << ", leaving it empty.";
+
+			dbg::printMessage(errMsg.str().c_str(), dbg::Urgency::ERROR);
+			continue;
+		}
+
+		if (!decoded.flips.empty() && tiles.flips.empty()) {
+			tiles.flips.assign(cellCount, 0);
+		}
 
-	int iw = static_cast<int>(this->width);	 // Int Width
-	int ih = static_cast<int>(this->height); // Int Height
+		int left = std::max(rect.left, firstCol);
+		int top = std::max(rect.top, firstRow);
+		int right = std::min(rect.left + rect.width, firstCol + size);
+		int bottom = std::min(rect.top + rect.height, firstRow + size);
 
-	// Out of bounds check.
-	if (entityXPos < 0 || entityXPos > iw || entityYPos < 0 || entityYPos > ih) {
+		for (int row = top; row < bottom; row++) {
+			for (int col = left; col < right; col++) {
+				std::size_t from =
+				    static_cast<std::size_t>(row - rect.top) * rect.width +
+				    (col - rect.left);
+				std::size_t to = static_cast<std::size_t>(row - firstRow) * size +
+						 (col - firstCol);
+
+				tiles.gids[to] = decoded.gids[from];
+
+				if (!decoded.flips.empty()) {
+					tiles.flips[to] = decoded.flips[from];
+				}
+			}
+		}
+	}
+}
+
+int tmx::Layer::getGid(int col, int row, std::uint8_t &tileFlips, const LayerChunk *chunk) const
+{
+	tileFlips = 0;
+
+	if (!this->infinite) {
+		std::size_t dataPos = static_cast<std::size_t>(row) * this->width + col;
+
+		if (this->data.size() <= dataPos) {
+			return 0;
+		}
+
+		tileFlips = getFlips(static_cast<int>(dataPos));
+		return this->data[dataPos];
+	}
+
+	int size = static_cast<int>(CHUNK_SIZE);
+
+	if (chunk == nullptr) {
+		auto found = this->chunks.find((row / size) * this->chunksX + col / size);
+
+		if (found == this->chunks.end()) {
+			return 0;
+		}
+
+		chunk = &found->second;
+	}
+
+	std::size_t pos = static_cast<std::size_t>(row % size) * size + col % size;
+
+	if (chunk->tiles.gids.size() <= pos) {
+		return 0;
+	}
+
+	if (!chunk->tiles.flips.empty()) {
+		tileFlips = chunk->tiles.flips[pos];
+	}
+
+	return chunk->tiles.gids[pos];
+}
+
+sf::FloatRect tmx::Layer::getTileBounds(int col, int row, const sf::IntRect &textureRect) const
+{
+	// Tiles sit on the bottom left corner of their cell, so bigger ones reach up and right.
+	float width = static_cast<float>(textureRect.width);
+	float height = static_cast<float>(textureRect.height);
+
+	return sf::FloatRect(col * static_cast<float>(this->tileWidth),
+			     (row + 1) * static_cast<float>(this->tileHeight) - height, width,
+			     height);
+}
+
+std::size_t tmx::Layer::getChunkBytes(const LayerChunk &chunk)
+{
+	std::size_t bytes = chunk.batches.capacity() * sizeof(Batch) +
+			    chunk.animatedTiles.capacity() * sizeof(AnimatedTile) +
+			    chunk.tiles.gids.capacity() * sizeof(int) +
+			    chunk.tiles.flips.capacity();
+
+	for (const Batch &batch : chunk.batches) {
+		bytes += batch.vertices.capacity() * sizeof(sf::Vertex);
+	}
+
+	return bytes;
+}
+
+bool tmx::Layer::hasTile(int col, int row) const
+{
+	if (col < 0 || row < 0 || col >= static_cast<int>(this->width) ||
+	    row >= static_cast<int>(this->height) || !this->gidTable) {
+		return false;
+	}
+
+	std::uint8_t tileFlips;
+	return this->gidTable->hasTile(getGid(col, row, tileFlips));
+}
+
+void tmx::Layer::storeChunk(unsigned int index, LayerChunk &&chunk)
+{
+	// A chunk can be built on the spot while its streamed copy is still on the way.
+	if (this->chunks.count(index) != 0) {
 		return;
 	}
 
-	// There is a better way to do this in a for loop, I'm just lazy so I'm doing it manually.
-	// It's that contradictory?
+	this->residentBytes += getChunkBytes(chunk);
+	this->chunks.emplace(index, std::move(chunk));
+	this->residentChunks.push_back(index);
 
-	// Store firstGid in shorthand to prevent compression.
-	int fGid = this->tileset.firstGid;
-	int dataSize = this->data.size();
-	sf::RectangleShape rect(sf::Vector2f(32.f, 32.f));
+	if (this->infinite && this->isBlocking) {
+		this->changedChunks.push_back(index);
+	}
+}
 
-	// Same position as entity
-	int dataPos = entityYPos * iw + entityXPos;
-	if (dataSize >= dataPos && this->data[dataPos] - fGid >= 0) {
-		this->sprite.setTextureRect(entityPosToTextureRect(entityYPos, entityXPos));
-		this->sprite.setPosition(entityXPos * this->tileset.tileWidth,
-					 entityYPos * this->tileset.tileHeight);
+void tmx::Layer::unloadChunk(unsigned int index)
+{
+	auto chunk = this->chunks.find(index);
 
-		window.draw(this->sprite);
+	if (chunk == this->chunks.end()) {
+		return;
 	}
 
-	// Below of entity
-	dataPos = (entityYPos + 1) * iw + entityXPos;
-	if (dataSize >= dataPos && this->data[dataPos] - fGid >= 0) {
-		this->sprite.setTextureRect(entityPosToTextureRect(entityYPos + 1, entityXPos));
-		this->sprite.setPosition(entityXPos * this->tileset.tileWidth,
-					 (entityYPos + 1) * this->tileset.tileHeight);
+	// The tiles of an infinite layer go with the vertices, they're decoded again if needed.
+	this->residentBytes -= getChunkBytes(chunk->second);
+	this->chunks.erase(chunk);
+
+	auto found = std::find(this->residentChunks.begin(), this->residentChunks.end(), index);
+	*found = this->residentChunks.back();
+	this->residentChunks.pop_back();
 
-		window.draw(this->sprite);
+	if (this->infinite && this->isBlocking) {
+		this->changedChunks.push_back(index);
 	}
+}
+
+bool tmx::Layer::isChunkResident(unsigned int index) const
+{
+	return this->chunks.count(index) != 0;
+}
 
-	// Above the entity
-	dataPos = (entityYPos - 1) * iw + entityXPos;
-	if (dataSize >= dataPos && this->data[dataPos] - fGid >= 0) {
-		this->sprite.setTextureRect(entityPosToTextureRect(entityYPos - 1, entityXPos));
-		this->sprite.setPosition(entityXPos * this->tileset.tileWidth,
-					 (entityYPos - 1) * this->tileset.tileHeight);
+void tmx::Layer::takeChangedChunks(std::vector<unsigned int> &indices)
+{
+	indices.insert(indices.end(), this->changedChunks.begin(), this->changedChunks.end());
+	this->changedChunks.clear();
+}
 
-		window.draw(this->sprite);
+const std::vector<unsigned int> &tmx::Layer::getResidentChunks() const
+{
+	return this->residentChunks;
+}
+
+std::size_t tmx::Layer::getResidentBytes() const
+{
+	return this->residentBytes;
+}
+
+unsigned int tmx::Layer::getChunksX() const
+{
+	return this->chunksX;
+}
+
+sf::FloatRect tmx::Layer::getChunkBounds(unsigned int index) const
+{
+	float width = static_cast<float>(CHUNK_SIZE * this->tileWidth);
+	float height = static_cast<float>(CHUNK_SIZE * this->tileHeight);
+
+	return sf::FloatRect((index % this->chunksX) * width, (index / this->chunksX) * height,
+			     width, height);
+}
+
+sf::IntRect tmx::Layer::regionToChunks(sf::Rect<float> region) const
+{
+	sf::IntRect tiles = regionToTiles(region);
+
+	if (tiles.width == 0 || tiles.height == 0) {
+		return sf::IntRect();
 	}
 
-	// Right of entity
-	dataPos = entityYPos * iw + (entityXPos + 1);
-	if (dataSize >= dataPos && this->data[dataPos] - fGid >= 0) {
-		this->sprite.setTextureRect(entityPosToTextureRect(entityYPos, entityXPos + 1));
-		this->sprite.setPosition((entityXPos + 1) * this->tileset.tileWidth,
-					 entityYPos * this->tileset.tileHeight);
+	int firstX = tiles.left / CHUNK_SIZE;
+	int firstY = tiles.top / CHUNK_SIZE;
+	int lastX = (tiles.left + tiles.width - 1) / CHUNK_SIZE;
+	int lastY = (tiles.top + tiles.height - 1) / CHUNK_SIZE;
+
+	return sf::IntRect(firstX, firstY, lastX - firstX + 1, lastY - firstY + 1);
+}
+
+void tmx::Layer::update(sf::Time deltaTime)
+{
+	// Only the clock moves here, chunks catch up when they are drawn.
+	this->animationTime += deltaTime;
+}
+
+void tmx::Layer::draw(render::Target &target, sf::Time deltaTime)
+{
+	// Drawing a whole streamed layer only draws what is resident.
+	drawChunks(target, this->residentChunks);
+}
 
-		window.draw(this->sprite);
+void tmx::Layer::drawRegion(render::Target &target, sf::Rect<float> region)
+{
+	// Overlay tiles are depth sorted with the entities, see collectOverlay.
+	if (this->isOverlay) {
+		return;
 	}
 
-	// Left of entity
-	dataPos = entityYPos * iw + (entityXPos - 1);
-	if (dataSize >= dataPos && this->data[dataPos] - fGid >= 0) {
-		this->sprite.setTextureRect(entityPosToTextureRect(entityYPos, entityXPos - 1));
-		this->sprite.setPosition((entityXPos - 1) * this->tileset.tileWidth,
-					 entityYPos * this->tileset.tileHeight);
+	// Visible chunks the streamer hasn't delivered yet are built here rather than popping in.
+	sf::IntRect range = regionToChunks(region);
+	this->visibleChunks.clear();
+
+	for (int y = range.top; y < range.top + range.height; y++) {
+		for (int x = range.left; x < range.left + range.width; x++) {
+			unsigned int index = y * this->chunksX + x;
 
-		window.draw(this->sprite);
+			if (!isChunkResident(index)) {
+				storeChunk(index, buildChunk(index));
+			}
+
+			this->visibleChunks.push_back(index);
+		}
 	}
 
-	// Top left of entity
-	dataPos = (entityYPos - 1) * iw + (entityXPos - 1);
-	if (dataSize >= dataPos && this->data[dataPos] - fGid >= 0) {
-		this->sprite.setTextureRect(entityPosToTextureRect(entityYPos - 1, entityXPos - 1));
-		this->sprite.setPosition((entityXPos - 1) * this->tileset.tileWidth,
-					 (entityYPos - 1) * this->tileset.tileHeight);
+	drawChunks(target, this->visibleChunks);
+}
 
-		window.draw(this->sprite);
+void tmx::Layer::drawChunks(render::Target &target, const std::vector<unsigned int> &indices)
+{
+	for (Batch &batch : this->drawBatches) {
+		batch.vertices.clear();
 	}
 
-	// Top right of entity
-	dataPos = (entityYPos - 1) * iw + (entityXPos + 1);
-	if (dataSize >= dataPos && this->data[dataPos] - fGid >= 0) {
-		this->sprite.setTextureRect(entityPosToTextureRect(entityYPos - 1, entityXPos + 1));
-		this->sprite.setPosition((entityXPos + 1) * this->tileset.tileWidth,
-					 (entityYPos - 1) * this->tileset.tileHeight);
+	for (unsigned int index : indices) {
+		auto found = this->chunks.find(index);
+
+		if (found == this->chunks.end()) {
+			continue;
+		}
+
+		LayerChunk &chunk = found->second;
 
-		window.draw(this->sprite);
+		animateChunk(chunk);
+
+		for (const Batch &batch : chunk.batches) {
+			auto drawBatch =
+			    std::find_if(this->drawBatches.begin(), this->drawBatches.end(),
+					 [&batch](const Batch &drawBatch) {
+						 return drawBatch.texture == batch.texture;
+					 });
+
+			if (drawBatch == this->drawBatches.end()) {
+				this->drawBatches.push_back(Batch{batch.texture, {}});
+				drawBatch = this->drawBatches.end() - 1;
+			}
+
+			drawBatch->vertices.insert(drawBatch->vertices.end(),
+						   batch.vertices.begin(), batch.vertices.end());
+		}
 	}
 
-	// Bottom left of entity
-	dataPos = (entityYPos + 1) * iw + (entityXPos - 1);
-	if (dataSize >= dataPos && this->data[dataPos] - fGid >= 0) {
-		this->sprite.setTextureRect(entityPosToTextureRect(entityYPos + 1, entityXPos - 1));
-		this->sprite.setPosition((entityXPos - 1) * this->tileset.tileWidth,
-					 (entityYPos + 1) * this->tileset.tileHeight);
+	// One draw call per texture for the whole visible part of the layer, a single one once
+	// the tilesets share an atlas.
+	for (const Batch &batch : this->drawBatches) {
+		if (batch.vertices.empty()) {
+			continue;
+		}
+
+		target.draw(batch.vertices.data(), batch.vertices.size(), sf::Quads,
+			    sf::RenderStates(batch.texture));
+	}
+}
 
-		window.draw(this->sprite);
+void tmx::Layer::animateChunk(LayerChunk &chunk)
+{
+	// Nothing to do until the earliest frame change in the chunk has passed.
+	if (chunk.animatedTiles.empty() || this->animationTime < chunk.nextChange) {
+		return;
 	}
 
-	// Bottom right of entity
-	dataPos = (entityYPos + 1) * iw + (entityXPos + 1);
-	if (dataSize >= (dataPos) && this->data[dataPos] - fGid >= 0) {
-		this->sprite.setTextureRect(entityPosToTextureRect(entityYPos + 1, entityXPos + 1));
-		this->sprite.setPosition((entityXPos + 1) * this->tileset.tileWidth,
-					 (entityYPos + 1) * this->tileset.tileHeight);
+	chunk.nextChange = sf::microseconds(std::numeric_limits<sf::Int64>::max());
+
+	for (AnimatedTile &tile : chunk.animatedTiles) {
+		const GidTable::Entry &entry = (*this->gidTable)[tile.gid];
+
+		sf::Time tileChange;
+		unsigned int localId = entry.tileset->getAnimationFrame(
+		    entry.animation, this->animationTime, tileChange);
+
+		chunk.nextChange = std::min(chunk.nextChange, tileChange);
+
+		if (localId == tile.localId) {
+			continue;
+		}
 
-		window.draw(this->sprite);
+		tile.localId = localId;
+
+		sf::IntRect rect = entry.tileset->getTextureRect(localId);
+		float left = static_cast<float>(rect.left);
+		float top = static_cast<float>(rect.top);
+		float right = left + static_cast<float>(rect.width);
+		float bottom = top + static_cast<float>(rect.height);
+
+		// Same vertex order as render::appendQuad.
+		sf::Vertex *quad = &chunk.batches[tile.batch].vertices[tile.vertex];
+		quad[0].texCoords = sf::Vector2f(left, top);
+		quad[1].texCoords = sf::Vector2f(right, top);
+		quad[2].texCoords = sf::Vector2f(right, bottom);
+		quad[3].texCoords = sf::Vector2f(left, bottom);
+		render::flipQuad(quad, tile.flips);
 	}
 }
 
-void tmx::Layer::drawRegion(sf::RenderWindow &window, sf::Time deltaTime, sf::Rect<float> region)
+void tmx::Layer::collectOverlay(sf::Rect<float> region, std::vector<render::Item> &items)
 {
-	// Clamp the regions x and y values to int.
-	int xMin = static_cast<int>(std::floor(region.left / this->tileset.tileWidth));
-	int yMin = static_cast<int>(std::floor(region.top / this->tileset.tileHeight));
-	int xMax =
-	    static_cast<int>(std::ceil((region.left + region.width) / this->tileset.tileWidth));
-	int yMax =
-	    static_cast<int>(std::ceil((region.top + region.height) / this->tileset.tileHeight));
+	if (!this->isOverlay) {
+		return;
+	}
+
+	// Infinite layers only know the tiles of resident chunks, visible ones the streamer
+	// hasn't delivered yet are built here.
+	if (this->infinite) {
+		sf::IntRect range = regionToChunks(region);
+
+		for (int y = range.top; y < range.top + range.height; y++) {
+			for (int x = range.left; x < range.left + range.width; x++) {
+				unsigned int index = y * this->chunksX + x;
+
+				if (!isChunkResident(index)) {
+					storeChunk(index, buildChunk(index));
+				}
+			}
+		}
+	}
 
-	int dataSize = this->data.size();
-	int fGid = this->tileset.firstGid;
-	int iw = static_cast<int>(this->width); // Int Width
+	// Every visible tile is emitted exactly once.
+	sf::IntRect tiles = regionToTiles(region);
 
-	// I know this is backwards, I initially did the math backwards and never fixed it.
-	for (int x = yMin; x < yMax; x++) {
-		for (int y = xMin; y < xMax; y++) {
-			int dataPos = x * iw + y;
+	for (int row = tiles.top; row < tiles.top + tiles.height; row++) {
+		for (int col = tiles.left; col < tiles.left + tiles.width; col++) {
+			std::uint8_t tileFlips;
+			int gid = getGid(col, row, tileFlips);
+			const GidTable::Entry &entry = (*this->gidTable)[gid];
 
-			if (dataSize <= dataPos || (this->data[dataPos] - fGid) < 0) {
+			if (!entry.tileset) {
 				continue;
 			}
 
-			this->sprite.setTextureRect(entityPosToTextureRect(x, y));
-			// clang-format off
-			this->sprite.setPosition(
-				(y * this->tileset.tileWidth),
-				(x * this->tileset.tileHeight)
-			);
-			// clang-format on
+			sf::IntRect textureRect = entry.textureRect;
+
+			if (entry.animation >= 0) {
+				sf::Time nextChange;
+				textureRect = entry.tileset->getTextureRect(
+				    entry.tileset->getAnimationFrame(entry.animation,
+								     this->animationTime,
+								     nextChange));
+			}
+
+			sf::FloatRect bounds = getTileBounds(col, row, entry.textureRect);
 
-			window.draw(this->sprite);
+			// Sorted by the bottom of the cell, where the tile stands.
+			items.push_back(render::Item{
+			    .depth = bounds.top + bounds.height,
+			    .bounds = bounds,
+			    .textureRect = textureRect,
+			    .texture = entry.texture,
+			    .color = sf::Color::White,
+			    .flips = tileFlips,
+			});
 		}
 	}
 }
+
+sf::IntRect tmx::Layer::regionToTiles(sf::Rect<float> region) const
+{
+	// Convert a world region to the range of tiles it touches, clamped to the layer.
+	float tileWidth = static_cast<float>(this->tileWidth);
+	float tileHeight = static_cast<float>(this->tileHeight);
+
+	int colMin = std::max(0, static_cast<int>(std::floor(region.left / tileWidth)));
+	int rowMin = std::max(0, static_cast<int>(std::floor(region.top / tileHeight)));
+	int colMax = std::min(static_cast<int>(this->width),
+			      static_cast<int>(std::ceil((region.left + region.width) /
+							 tileWidth)));
+	int rowMax = std::min(static_cast<int>(this->height),
+			      static_cast<int>(std::ceil((region.top + region.height) /
+							 tileHeight)));
+
+	return sf::IntRect(colMin, rowMin, std::max(0, colMax - colMin),
+			   std::max(0, rowMax - rowMin));
+}
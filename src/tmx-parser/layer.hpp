@@ -5,18 +5,24 @@
 #include <SFML/System.hpp>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <tinyxml2.h>
+#include <unordered_map>
 #include <vector>
 
 #include "../debug.hpp"
-#include "tile.hpp"
+#include "gid-grid.hpp"
+#include "gid-table.hpp"
 #include "tileset.hpp"
 
-#include "../components/transform.hpp"
+#include "../render/render_item.hpp"
+#include "../render/target.hpp"
 
 namespace tmx
 {
@@ -34,45 +40,158 @@ public:
 	Layer()
 	{
 	}
-	explicit Layer(tinyxml2::XMLElement *layerElement);
+	// Chunk text is read from source, the mapped map file, see placeChunks.
+	explicit Layer(tinyxml2::XMLElement *layerElement,
+		       std::shared_ptr<const char> source = nullptr, std::size_t sourceSize = 0);
 
 	unsigned int id;
 	std::string name;
 	unsigned int width;
 	unsigned int height;
 
-	std::vector<int> data;
-	std::vector<std::vector<MapTile>> tiles;
+	GidGrid data; // Gids without their flag bits
+	std::vector<std::uint8_t> flips; // render::Flip bits per tile, empty when none are set
 
-	Tileset tileset;
+	// The map's cell size, tiles bigger than a cell stick out of its top like in Tiled.
+	unsigned int tileWidth = 32;
+	unsigned int tileHeight = 32;
+
+	// Resolves the gids of every layer of the map, shared with the map.
+	std::shared_ptr<const GidTable> gidTable;
 
 	tmx::Encoding encoding;
-	sf::Sprite sprite;
+
+	// Infinite maps store layers as chunks. Their text stays in the map file and data stays
+	// empty, each chunk is decoded when a chunk it covers is built and goes when that chunk is
+	// unloaded. Once every layer is read the map moves them so the chunks of all layers start
+	// at tile 0, origin is the tile that was at the top left.
+	bool infinite = false;
+	sf::IntRect getSourceBounds() const;
+	void placeChunks(sf::Vector2i origin, unsigned int width, unsigned int height);
 
 	void init();
-	void draw(sf::RenderWindow &window, sf::Time deltaTime);
-	void drawPosition(sf::RenderWindow &window, sf::Time deltaTime, const Transform &entityPos);
-	void drawRegion(sf::RenderWindow &window, sf::Time deltaTime, sf::Rect<float> region);
+	void draw(render::Target &target, sf::Time deltaTime);
+	void drawRegion(render::Target &target, sf::Rect<float> region);
+	void collectOverlay(sf::Rect<float> region, std::vector<render::Item> &items);
 	void update(sf::Time deltaTime);
 
 	bool isBlocking;
 	bool isOverlay;
 
+	// Category bits of the layer's blocking tiles, matched against CollisionFilter masks.
+	unsigned int collisionCategory = 1;
+
+	// Rebuilds the cached chunk vertices, needed after the tileset UVs change.
+	void buildChunks();
+
+	// Tiles of infinite layers are only known while their chunk is resident.
+	bool hasTile(int col, int row) const;
+
+	// Streamed layers only keep the chunks around the view, see Map::setStreamingView.
+	// Everything else is built up front.
+	bool streamed = false;
+
+	static const unsigned int CHUNK_SIZE = 16;
+
+	// A chunk's tiles from one texture, drawn together with the other chunks' batches of it.
+	struct Batch {
+		const sf::Texture *texture;
+		std::vector<sf::Vertex> vertices;
+	};
+
+	struct AnimatedTile {
+		std::size_t batch;
+		std::size_t vertex; // First of the tile's four vertices in the batch.
+		int gid;
+		unsigned int localId; // Frame currently written to the vertices.
+		std::uint8_t flips;
+	};
+
+	// Gids without their flag bits and the render::Flip bits of each, flips stays empty
+	// when no tile is flipped.
+	struct Tiles {
+		std::vector<int> gids;
+		std::vector<std::uint8_t> flips;
+	};
+
+	struct LayerChunk {
+		std::vector<Batch> batches;
+		std::vector<AnimatedTile> animatedTiles;
+		sf::Time nextChange;
+		// CHUNK_SIZE rows of CHUNK_SIZE tiles on infinite layers, empty otherwise.
+		Tiles tiles;
+	};
+
+	// Chunks are numbered row by row, regionToChunks gives the range a world region touches.
+	sf::IntRect regionToChunks(sf::Rect<float> region) const;
+	sf::FloatRect getChunkBounds(unsigned int index) const;
+	unsigned int getChunksX() const;
+
+	// buildChunk only reads the gids (or the map file) and the gid table, so it can run on
+	// another thread while the layer is drawn.
+	LayerChunk buildChunk(unsigned int index) const;
+	void storeChunk(unsigned int index, LayerChunk &&chunk);
+	void unloadChunk(unsigned int index);
+	bool isChunkResident(unsigned int index) const;
+
+	const std::vector<unsigned int> &getResidentChunks() const;
+	std::size_t getResidentBytes() const;
+
+	// Chunks of a blocking infinite layer stored or unloaded since the last call, appended to
+	// indices. The map rebuilds their collision.
+	void takeChangedChunks(std::vector<unsigned int> &indices);
+
 private:
-	sf::IntRect entityPosToTextureRect(int x, int y)
-	{
-		if (x < 0 || y < 0) {
-			return sf::IntRect();
-		}
-
-		return sf::IntRect(((this->data[x * this->width + y] - this->tileset.firstGid) %
-				    this->tileset.columns) *
-				       this->tileset.tileWidth,
-				   ((this->data[x * this->width + y] - this->tileset.firstGid) /
-				    this->tileset.columns) *
-				       this->tileset.tileHeight,
-				   this->tileset.tileWidth, this->tileset.tileHeight);
-	}
+	// Keyed by index, only resident chunks are in it.
+	std::unordered_map<unsigned int, LayerChunk> chunks;
+	unsigned int chunksX = 0;
+	unsigned int chunksY = 0;
+
+	std::vector<unsigned int> residentChunks;
+	std::size_t residentBytes = 0;
+	std::vector<unsigned int> changedChunks;
+
+	// A chunk of an infinite layer as Tiled saved it, its text is length bytes at offset in
+	// source.
+	struct SourceChunk {
+		sf::IntRect rect;
+		std::size_t offset;
+		std::size_t length;
+	};
+
+	std::vector<SourceChunk> sourceChunks;
+	std::shared_ptr<const char> source;
+
+	// The source chunks covering each chunk index, built by placeChunks.
+	std::unordered_map<unsigned int, std::vector<std::uint32_t>> chunkSources;
+
+	// Drives the tile animations, shared by all tiles in the layer.
+	sf::Time animationTime;
+
+	// Scratch batches reused by the draw calls, one per texture.
+	std::vector<Batch> drawBatches;
+	std::vector<unsigned int> visibleChunks;
+
+	// Decode count tiles from the text between text and end, appended to tiles.
+	bool parseData(const char *text, const char *end, std::size_t count, Tiles &tiles) const;
+	bool parseCsvData(const char *text, const char *end, std::size_t count, Tiles &tiles) const;
+	bool decodeBase64Data(const char *text, const char *end, std::size_t count,
+			      bool compressed, Tiles &tiles) const;
+	static void appendGid(std::uint32_t gid, Tiles &tiles);
+	void decodeChunk(unsigned int index, Tiles &tiles) const;
+
+	std::uint8_t getFlips(int dataPos) const;
+
+	// Gid and flips of a cell. Infinite layers read them from the resident chunk holding
+	// the cell, or from chunk while it's being built.
+	int getGid(int col, int row, std::uint8_t &tileFlips,
+		   const LayerChunk *chunk = nullptr) const;
+
+	sf::IntRect regionToTiles(sf::Rect<float> region) const;
+	sf::FloatRect getTileBounds(int col, int row, const sf::IntRect &textureRect) const;
+	static std::size_t getChunkBytes(const LayerChunk &chunk);
+	void drawChunks(render::Target &target, const std::vector<unsigned int> &indices);
+	void animateChunk(LayerChunk &chunk);
 };
 } // namespace tmx
 
@@ -0,0 +1,480 @@
+#include "map-cache.hpp"
+#include "../debug.hpp"
+#include "map.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+
+namespace
+{
+const char CACHE_MAGIC[4] = {'T', 'M', 'X', 'C'};
+const std::uint32_t CACHE_VERSION = 4;
+
+struct SourceStamp {
+	std::int64_t modified; // Nanoseconds
+	std::uint64_t size;
+};
+
+bool stampFile(const std::string &path, SourceStamp &stamp)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0) {
+		return false;
+	}
+
+	stamp.modified = static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 +
+			 info.st_mtim.tv_nsec;
+	stamp.size = static_cast<std::uint64_t>(info.st_size);
+
+	return true;
+}
+
+class CacheWriter
+{
+public:
+	explicit CacheWriter(const std::string &path) : file(path, std::ios::binary)
+	{
+	}
+
+	template <typename T> void write(const T &value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "cached values are raw bytes");
+		writeBytes(&value, sizeof(T));
+	}
+
+	void writeString(const std::string &value)
+	{
+		write(static_cast<std::uint32_t>(value.size()));
+		writeBytes(value.data(), value.size());
+	}
+
+	// Arrays start on an 8 byte boundary so they can be used straight from the mapping.
+	template <typename T> void writeArray(const T *items, std::size_t count)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "cached values are raw bytes");
+
+		write(static_cast<std::uint64_t>(count));
+		align();
+		writeBytes(items, count * sizeof(T));
+	}
+
+	template <typename T> void writeArray(const std::vector<T> &items)
+	{
+		writeArray(items.data(), items.size());
+	}
+
+	bool good() const
+	{
+		return static_cast<bool>(this->file);
+	}
+
+	void close()
+	{
+		this->file.close();
+	}
+
+private:
+	void writeBytes(const void *bytes, std::size_t count)
+	{
+		this->file.write(static_cast<const char *>(bytes), count);
+		this->offset += count;
+	}
+
+	void align()
+	{
+		const char padding[8] = {};
+		writeBytes(padding, (8 - this->offset % 8) % 8);
+	}
+
+	std::ofstream file;
+	std::size_t offset = 0;
+};
+
+class CacheReader
+{
+public:
+	CacheReader(const char *base, std::size_t size) : base(base), size(size)
+	{
+	}
+
+	template <typename T> T read()
+	{
+		T value{};
+
+		if (this->offset + sizeof(T) > this->size) {
+			this->failed = true;
+			return value;
+		}
+
+		std::memcpy(&value, this->base + this->offset, sizeof(T));
+		this->offset += sizeof(T);
+
+		return value;
+	}
+
+	std::string readString()
+	{
+		std::uint32_t length = read<std::uint32_t>();
+
+		if (this->failed || this->offset + length > this->size) {
+			this->failed = true;
+			return std::string();
+		}
+
+		std::string value(this->base + this->offset, length);
+		this->offset += length;
+
+		return value;
+	}
+
+	// Points into the mapping, valid while it is.
+	template <typename T> const T *readArray(std::size_t &count)
+	{
+		count = static_cast<std::size_t>(read<std::uint64_t>());
+		this->offset += (8 - this->offset % 8) % 8;
+
+		std::size_t left = this->size - std::min(this->offset, this->size);
+
+		if (this->failed || count > left / sizeof(T)) {
+			this->failed = true;
+			count = 0;
+			return nullptr;
+		}
+
+		const T *items = reinterpret_cast<const T *>(this->base + this->offset);
+		this->offset += count * sizeof(T);
+
+		return items;
+	}
+
+	template <typename T> std::vector<T> readVector()
+	{
+		std::size_t count = 0;
+		const T *items = readArray<T>(count);
+
+		return items ? std::vector<T>(items, items + count) : std::vector<T>();
+	}
+
+	bool failed = false;
+
+private:
+	const char *base;
+	std::size_t size;
+	std::size_t offset = 0;
+};
+} // namespace
+
+std::shared_ptr<const char> tmx::mapFile(const std::string &path, std::size_t &size)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return nullptr;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		return nullptr;
+	}
+
+	size = static_cast<std::size_t>(info.st_size);
+	void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (address == MAP_FAILED) {
+		return nullptr;
+	}
+
+	return std::shared_ptr<const char>(static_cast<const char *>(address),
+					   [size](const char *mapped) {
+						   munmap(const_cast<char *>(mapped), size);
+					   });
+}
+
+bool tmx::loadMapCache(const std::string &path, Map &map)
+{
+	// Any mismatch leaves the map untouched and returns false, so it can be parsed instead
+
+	std::size_t size = 0;
+	std::shared_ptr<const char> mapping = tmx::mapFile(path, size);
+
+	if (!mapping) {
+		return false;
+	}
+
+	CacheReader reader(mapping.get(), size);
+
+	char magic[4];
+	for (char &c : magic) {
+		c = reader.read<char>();
+	}
+
+	if (std::memcmp(magic, CACHE_MAGIC, 4) != 0 ||
+	    reader.read<std::uint32_t>() != CACHE_VERSION) {
+		return false;
+	}
+
+	std::uint32_t sourceCount = reader.read<std::uint32_t>();
+	for (std::uint32_t i = 0; i < sourceCount && !reader.failed; i++) {
+		std::string sourcePath = reader.readString();
+		SourceStamp cached = reader.read<SourceStamp>();
+		SourceStamp current;
+
+		if (!stampFile(sourcePath, current) || current.modified != cached.modified ||
+		    current.size != cached.size) {
+			return false;
+		}
+	}
+
+	Map loaded;
+	loaded.version = reader.read<double>();
+	loaded.orientation = reader.readString();
+	loaded.renderOrder = reader.readString();
+	loaded.width = reader.read<std::uint32_t>();
+	loaded.height = reader.read<std::uint32_t>();
+	loaded.tileWidth = reader.read<std::uint32_t>();
+	loaded.tileHeight = reader.read<std::uint32_t>();
+	loaded.infinite = reader.read<std::uint8_t>() != 0;
+
+	// Infinite maps decode their chunks from the map file as they stream in.
+	if (loaded.infinite) {
+		return false;
+	}
+
+	loaded.origin.x = reader.read<std::int32_t>();
+	loaded.origin.y = reader.read<std::int32_t>();
+
+	loaded.tilesets.resize(reader.read<std::uint32_t>());
+	for (Tileset &tileset : loaded.tilesets) {
+		tileset.firstGid = reader.read<std::int32_t>();
+		tileset.source = reader.readString();
+		tileset.sourcePath = reader.readString();
+		tileset.version = reader.read<double>();
+		tileset.name = reader.readString();
+		tileset.tileWidth = reader.read<std::uint32_t>();
+		tileset.tileHeight = reader.read<std::uint32_t>();
+		tileset.tileCount = reader.read<std::uint32_t>();
+		tileset.columns = reader.read<std::uint32_t>();
+		tileset.imagePath = reader.readString();
+		tileset.animationFrames = reader.readVector<TileFrame>();
+		tileset.animations = reader.readVector<TileAnimation>();
+		tileset.animationLookup = reader.readVector<int>();
+	}
+
+	loaded.layers.resize(reader.read<std::uint32_t>());
+	for (Layer &layer : loaded.layers) {
+		layer.id = reader.read<std::uint32_t>();
+		layer.name = reader.readString();
+		layer.width = reader.read<std::uint32_t>();
+		layer.height = reader.read<std::uint32_t>();
+		layer.encoding = static_cast<Encoding>(reader.read<std::uint32_t>());
+		layer.isBlocking = reader.read<std::uint8_t>() != 0;
+		layer.isOverlay = reader.read<std::uint8_t>() != 0;
+		layer.collisionCategory = reader.read<std::uint32_t>();
+
+		std::size_t count = 0;
+		if (reader.read<std::uint8_t>() != 0) {
+			const std::uint16_t *gids = reader.readArray<std::uint16_t>(count);
+			layer.data.assignMapped(gids, count, true, mapping);
+		} else {
+			const int *gids = reader.readArray<int>(count);
+			layer.data.assignMapped(gids, count, false, mapping);
+		}
+		layer.flips = reader.readVector<std::uint8_t>();
+
+		// getFlips and the chunk builders index both arrays by cell.
+		std::size_t cellCount = static_cast<std::size_t>(layer.width) * layer.height;
+
+		if (reader.failed || count != cellCount ||
+		    (!layer.flips.empty() && layer.flips.size() != count)) {
+			dbg::printMessage("Map cache has a corrupt layer, parsing the map instead.",
+					  dbg::Urgency::WARNING);
+			return false;
+		}
+	}
+
+	loaded.objectGroups.resize(reader.read<std::uint32_t>());
+	for (ObjectGroup &group : loaded.objectGroups) {
+		group.id = reader.read<std::uint32_t>();
+		group.name = reader.readString();
+		group.objects.resize(reader.read<std::uint32_t>());
+
+		for (Object &object : group.objects) {
+			object.id = reader.read<std::uint32_t>();
+			object.name = reader.readString();
+			object.type = reader.readString();
+			object.x = reader.read<std::uint32_t>();
+			object.y = reader.read<std::uint32_t>();
+			object.width = reader.read<std::uint32_t>();
+			object.height = reader.read<std::uint32_t>();
+			object.visible = reader.read<std::uint8_t>() != 0;
+			object.luaScript = reader.readString();
+			object.property = static_cast<ObjectProperty>(reader.read<std::uint32_t>());
+		}
+	}
+
+	loaded.collisionLayers.resize(reader.read<std::uint32_t>());
+	for (Map::CollisionLayer &collision : loaded.collisionLayers) {
+		collision.category = reader.read<std::uint32_t>();
+
+		std::uint32_t width = reader.read<std::uint32_t>();
+		std::uint32_t height = reader.read<std::uint32_t>();
+		sf::Vector2f tileSize = reader.read<sf::Vector2f>();
+
+		std::size_t wordCount = 0;
+		const std::uint64_t *words = reader.readArray<std::uint64_t>(wordCount);
+
+		if (reader.failed ||
+		    wordCount != static_cast<std::size_t>((width + 63) / 64) * height) {
+			return false;
+		}
+
+		collision.bitmap.assign(width, height, tileSize, words);
+		collision.geometry.setCells(reader.readVector<sf::Rect<unsigned int>>(),
+					    loaded.tileWidth, loaded.tileHeight);
+	}
+
+	if (reader.failed) {
+		dbg::printMessage("Map cache is truncated, parsing the map instead.",
+				  dbg::Urgency::WARNING);
+		return false;
+	}
+
+	map = std::move(loaded);
+	return true;
+}
+
+bool tmx::saveMapCache(const std::string &path, const Map &map,
+		       const std::vector<std::string> &sources)
+{
+	// Written to a temporary file first so a reader never maps a half written cache. The
+	// name is unique to the process and thread, so two writers of the same map don't write
+	// into each other's file, the last rename wins.
+
+	std::ostringstream tempName;
+	tempName << path << "." << getpid() << "."
+		 << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp";
+	std::string tempPath = tempName.str();
+
+	{
+		CacheWriter writer(tempPath);
+
+		for (char c : CACHE_MAGIC) {
+			writer.write(c);
+		}
+
+		writer.write(CACHE_VERSION);
+		writer.write(static_cast<std::uint32_t>(sources.size()));
+
+		for (const std::string &source : sources) {
+			SourceStamp stamp;
+			if (!stampFile(source, stamp)) {
+				writer.close();
+				std::remove(tempPath.c_str());
+				return false;
+			}
+
+			writer.writeString(source);
+			writer.write(stamp);
+		}
+
+		writer.write(map.version);
+		writer.writeString(map.orientation);
+		writer.writeString(map.renderOrder);
+		writer.write(static_cast<std::uint32_t>(map.width));
+		writer.write(static_cast<std::uint32_t>(map.height));
+		writer.write(static_cast<std::uint32_t>(map.tileWidth));
+		writer.write(static_cast<std::uint32_t>(map.tileHeight));
+		writer.write(static_cast<std::uint8_t>(map.infinite));
+		writer.write(static_cast<std::int32_t>(map.origin.x));
+		writer.write(static_cast<std::int32_t>(map.origin.y));
+
+		writer.write(static_cast<std::uint32_t>(map.tilesets.size()));
+		for (const Tileset &tileset : map.tilesets) {
+			writer.write(static_cast<std::int32_t>(tileset.firstGid));
+			writer.writeString(tileset.source);
+			writer.writeString(tileset.sourcePath);
+			writer.write(tileset.version);
+			writer.writeString(tileset.name);
+			writer.write(static_cast<std::uint32_t>(tileset.tileWidth));
+			writer.write(static_cast<std::uint32_t>(tileset.tileHeight));
+			writer.write(static_cast<std::uint32_t>(tileset.tileCount));
+			writer.write(static_cast<std::uint32_t>(tileset.columns));
+			writer.writeString(tileset.imagePath);
+			writer.writeArray(tileset.animationFrames);
+			writer.writeArray(tileset.animations);
+			writer.writeArray(tileset.animationLookup);
+		}
+
+		writer.write(static_cast<std::uint32_t>(map.layers.size()));
+		for (const Layer &layer : map.layers) {
+			writer.write(static_cast<std::uint32_t>(layer.id));
+			writer.writeString(layer.name);
+			writer.write(static_cast<std::uint32_t>(layer.width));
+			writer.write(static_cast<std::uint32_t>(layer.height));
+			writer.write(static_cast<std::uint32_t>(layer.encoding));
+			writer.write(static_cast<std::uint8_t>(layer.isBlocking));
+			writer.write(static_cast<std::uint8_t>(layer.isOverlay));
+			writer.write(static_cast<std::uint32_t>(layer.collisionCategory));
+			writer.write(static_cast<std::uint8_t>(layer.data.isNarrow()));
+			if (layer.data.isNarrow()) {
+				writer.writeArray(
+				    static_cast<const std::uint16_t *>(layer.data.getCells()),
+				    layer.data.size());
+			} else {
+				writer.writeArray(static_cast<const int *>(layer.data.getCells()),
+						  layer.data.size());
+			}
+			writer.writeArray(layer.flips);
+		}
+
+		writer.write(static_cast<std::uint32_t>(map.objectGroups.size()));
+		for (const ObjectGroup &group : map.objectGroups) {
+			writer.write(static_cast<std::uint32_t>(group.id));
+			writer.writeString(group.name);
+			writer.write(static_cast<std::uint32_t>(group.objects.size()));
+
+			for (const Object &object : group.objects) {
+				writer.write(static_cast<std::uint32_t>(object.id));
+				writer.writeString(object.name);
+				writer.writeString(object.type);
+				writer.write(static_cast<std::uint32_t>(object.x));
+				writer.write(static_cast<std::uint32_t>(object.y));
+				writer.write(static_cast<std::uint32_t>(object.width));
+				writer.write(static_cast<std::uint32_t>(object.height));
+				writer.write(static_cast<std::uint8_t>(object.visible));
+				writer.writeString(object.luaScript);
+				writer.write(static_cast<std::uint32_t>(object.property));
+			}
+		}
+
+		writer.write(static_cast<std::uint32_t>(map.collisionLayers.size()));
+		for (const Map::CollisionLayer &collision : map.collisionLayers) {
+			writer.write(static_cast<std::uint32_t>(collision.category));
+			writer.write(static_cast<std::uint32_t>(collision.bitmap.getWidth()));
+			writer.write(static_cast<std::uint32_t>(collision.bitmap.getHeight()));
+			writer.write(collision.bitmap.getTileSize());
+			writer.writeArray(collision.bitmap.getWords());
+			writer.writeArray(collision.geometry.getCells());
+		}
+
+		if (!writer.good()) {
+			std::remove(tempPath.c_str());
+			return false;
+		}
+	}
+
+	return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,26 @@
+#ifndef TMX_PARSER_MAP_CACHE_HPP
+#define TMX_PARSER_MAP_CACHE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tmx
+{
+class Map;
+
+/* A parsed map written out as flat, 8 byte aligned arrays: the header, tilesets, gid grids,
+ * object groups and collision data. Loading maps the file and points the layers' gids into
+ * it, so nothing is parsed and the gids aren't copied. The cache records the size and
+ * modification time of every file the map was parsed from and is ignored once any changes.
+ * Infinite maps aren't cached, see Layer::placeChunks. */
+bool loadMapCache(const std::string &path, Map &map);
+bool saveMapCache(const std::string &path, const Map &map, const std::vector<std::string> &sources);
+
+// The whole file mapped read only, unmapped once the last user of it is gone. Null for a
+// missing or empty file.
+std::shared_ptr<const char> mapFile(const std::string &path, std::size_t &size);
+} // namespace tmx
+
+#endif
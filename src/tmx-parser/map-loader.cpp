@@ -0,0 +1,217 @@
+#include "map-loader.hpp"
+#include "../debug.hpp"
+
+#include <algorithm>
+
+namespace
+{
+// Share of the progress bar each step takes.
+const float PARSE_SHARE = 0.5f;
+const float DECODE_SHARE = 0.3f;
+const float UPLOAD_SHARE = 0.2f;
+} // namespace
+
+tmx::MapLoader::MapLoader(unsigned int threads)
+{
+	for (unsigned int i = 0; i < std::max(1u, threads); i++) {
+		this->workers.emplace_back(&MapLoader::run, this);
+	}
+}
+
+tmx::MapLoader::~MapLoader()
+{
+	// Queued work is dropped, a map already being parsed is finished first.
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+		this->tasks.clear();
+	}
+
+	this->wake.notify_all();
+
+	for (std::thread &worker : this->workers) {
+		worker.join();
+	}
+}
+
+tmx::MapLoader::Handle tmx::MapLoader::load(const std::string &basePath,
+					     const std::string &filename)
+{
+	std::shared_ptr<Job> job = std::make_shared<Job>();
+	job->basePath = basePath;
+	job->filename = filename;
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		job->handle = this->nextHandle++;
+		this->jobs.push_back(job);
+		this->tasks.push_back(Task{job, -1});
+	}
+
+	this->wake.notify_one();
+
+	return job->handle;
+}
+
+void tmx::MapLoader::upload(sf::Time budget)
+{
+	// Textures are only touched here, so the drawing thread never sees a half uploaded one
+
+	sf::Clock clock;
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	for (std::size_t i = 0; i < this->jobs.size(); i++) {
+		std::shared_ptr<Job> job = this->jobs[i];
+
+		while (job->map && job->uploaded < job->images.size() &&
+		       job->isDecoded[job->uploaded]) {
+			// Decoded images aren't written again, no lock is needed for the upload.
+			std::size_t index = job->uploaded;
+			lock.unlock();
+
+			Tileset &tileset = job->map->tilesets[index];
+			if (!tileset.loadTexture(job->images[index])) {
+				std::ostringstream errMsg;
+				errMsg << "Unable to upload the tileset image " << tileset.imagePath
+				       << ".";
+
+				dbg::printMessage(errMsg.str().c_str(), dbg::Urgency::WARNING);
+			}
+
+			lock.lock();
+			job->uploaded++;
+
+			// Checked after the upload, so a frame that starts over budget still makes
+			// progress.
+			if (clock.getElapsedTime() > budget) {
+				return;
+			}
+		}
+	}
+}
+
+float tmx::MapLoader::getProgress(Handle handle) const
+{
+	std::shared_ptr<Job> job = find(handle);
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	if (!job || !job->map) {
+		return 0.f;
+	}
+
+	std::size_t count = job->map->tilesets.size();
+
+	if (count == 0) {
+		return 1.f;
+	}
+
+	return PARSE_SHARE + DECODE_SHARE * job->decoded / count +
+	       UPLOAD_SHARE * job->uploaded / count;
+}
+
+bool tmx::MapLoader::isReady(Handle handle) const
+{
+	std::shared_ptr<Job> job = find(handle);
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	return job && job->map && job->uploaded == job->map->tilesets.size();
+}
+
+tmx::Map tmx::MapLoader::take(Handle handle, std::vector<sf::Image> *images)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	auto found = std::find_if(
+	    this->jobs.begin(), this->jobs.end(),
+	    [handle](const std::shared_ptr<Job> &job) { return job->handle == handle; });
+
+	if (found == this->jobs.end() || !(*found)->map ||
+	    (*found)->uploaded != (*found)->map->tilesets.size()) {
+		dbg::printMessage("Map taken from the loader before it was ready.",
+				  dbg::Urgency::ERROR);
+		return Map();
+	}
+
+	std::shared_ptr<Job> job = *found;
+	this->jobs.erase(found);
+
+	if (images != nullptr) {
+		images->swap(job->images);
+	}
+
+	return std::move(*job->map);
+}
+
+void tmx::MapLoader::run()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	while (true) {
+		this->wake.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+
+		if (this->stopping) {
+			return;
+		}
+
+		Task task = this->tasks.front();
+		this->tasks.pop_front();
+		lock.unlock();
+
+		if (task.image < 0) {
+			parse(task.job);
+		} else {
+			// Images are decoded in any order but uploaded in tileset order.
+			const Tileset &tileset = task.job->map->tilesets[task.image];
+
+			if (!task.job->images[task.image].loadFromFile(tileset.imagePath)) {
+				std::ostringstream errMsg;
+				errMsg << "Unable to decode the tileset image " << tileset.imagePath
+				       << ".";
+
+				dbg::printMessage(errMsg.str().c_str(), dbg::Urgency::WARNING);
+			}
+		}
+
+		lock.lock();
+
+		if (task.image >= 0) {
+			task.job->isDecoded[task.image] = true;
+			task.job->decoded++;
+		}
+	}
+}
+
+void tmx::MapLoader::parse(const std::shared_ptr<Job> &job)
+{
+	// Everything but the textures, then one decode task per tileset image
+
+	std::unique_ptr<Map> map = std::make_unique<Map>(job->basePath, job->filename, false);
+	std::size_t count = map->tilesets.size();
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		job->images.resize(count);
+		job->isDecoded.assign(count, false);
+		job->map = std::move(map);
+
+		for (std::size_t i = 0; i < count; i++) {
+			this->tasks.push_back(Task{job, static_cast<int>(i)});
+		}
+	}
+
+	this->wake.notify_all();
+}
+
+std::shared_ptr<tmx::MapLoader::Job> tmx::MapLoader::find(Handle handle) const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	for (const std::shared_ptr<Job> &job : this->jobs) {
+		if (job->handle == handle) {
+			return job;
+		}
+	}
+
+	return nullptr;
+}
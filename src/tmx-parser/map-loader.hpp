@@ -0,0 +1,80 @@
+#ifndef TMX_PARSER_MAP_LOADER_HPP
+#define TMX_PARSER_MAP_LOADER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "map.hpp"
+
+namespace tmx
+{
+/* Loads maps without blocking the thread that draws. Workers parse the map and decode the
+ * tileset images, the drawing thread uploads the decoded images to textures a few at a time
+ * through upload(). Several maps can be loading at once, each is identified by the handle
+ * load() returns. */
+class MapLoader
+{
+public:
+	typedef unsigned int Handle;
+
+	explicit MapLoader(unsigned int threads = 1);
+	~MapLoader();
+
+	MapLoader(const MapLoader &) = delete;
+	MapLoader &operator=(const MapLoader &) = delete;
+
+	Handle load(const std::string &basePath, const std::string &filename);
+
+	// Uploads decoded images to the tilesets' textures until budget has passed, at least one
+	// per call. Call once a frame from the thread that draws.
+	void upload(sf::Time budget);
+
+	// 0 to 1, parsing is the first half, decoding and uploading the images the rest.
+	float getProgress(Handle handle) const;
+	bool isReady(Handle handle) const;
+
+	// Hands over a ready map, the handle can't be used afterwards. images gets the decoded
+	// tileset images in tileset order, so they don't have to be decoded again for an atlas.
+	Map take(Handle handle, std::vector<sf::Image> *images = nullptr);
+
+private:
+	struct Job {
+		Handle handle;
+		std::string basePath;
+		std::string filename;
+
+		std::unique_ptr<Map> map; // Set once parsed.
+		std::vector<sf::Image> images;
+		std::vector<bool> isDecoded;
+		std::size_t decoded = 0;
+		std::size_t uploaded = 0;
+	};
+
+	// A map to parse, or one of its images to decode.
+	struct Task {
+		std::shared_ptr<Job> job;
+		int image; // -1 to parse the map.
+	};
+
+	void run();
+	void parse(const std::shared_ptr<Job> &job);
+	std::shared_ptr<Job> find(Handle handle) const;
+
+	std::vector<std::thread> workers;
+	mutable std::mutex mutex;
+	std::condition_variable wake;
+
+	std::deque<Task> tasks;
+	std::vector<std::shared_ptr<Job>> jobs;
+	Handle nextHandle = 0;
+	bool stopping = false;
+};
+} // namespace tmx
+
+#endif
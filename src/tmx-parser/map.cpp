@@ -1,10 +1,42 @@
 #include "map.hpp"
 #include "../debug.hpp"
+#include "../defs.hpp"
+#include "layer-data.hpp"
+#include "map-cache.hpp"
 
-tmx::Map::Map(const std::string &basePath, const std::string &filename)
+#include <algorithm>
+#include <cmath>
+
+tmx::Map::Map(const std::string &basePath, const std::string &filename, bool loadTextures)
 {
+	std::string mapPath = basePath + "/" + filename;
+	std::string cachePath = mapPath + ".cache";
+
+	// The cache skips all the parsing below, it's rewritten whenever it's out of date.
+	if (tmx::loadMapCache(cachePath, *this)) {
+		if (loadTextures) {
+			this->loadTextures();
+		}
+
+		initLayers();
+		dbg::printMessage("Loaded the map from its cache.", dbg::Urgency::DEFAULT);
+		return;
+	}
+
+	// Chunk text is left in the mapped file for the layers to decode as it streams in, the
+	// document only gets the rest.
+	std::size_t sourceSize = 0;
+	std::shared_ptr<const char> source = tmx::mapFile(mapPath, sourceSize);
+	std::string stripped;
+
 	tinyxml2::XMLDocument doc;
-	doc.LoadFile((basePath + "/" + filename).c_str());
+	if (!source) {
+		doc.LoadFile(mapPath.c_str());
+	} else if (tmx::stripChunkData(source.get(), sourceSize, stripped)) {
+		doc.Parse(stripped.data(), stripped.size());
+	} else {
+		doc.Parse(source.get(), sourceSize);
+	}
 
 	// Set default values (in case of error).
 	this->version = 0.0;
@@ -84,6 +116,9 @@ tmx::Map::Map(const std::string &basePath, const std::string &filename)
 		dbg::printMessage(errMsg.str().c_str(), dbg::Urgency::WARNING);
 	}
 
+	// Infinite maps take their size from the chunks instead, see placeChunks.
+	mapRoot->QueryBoolAttribute("infinite", &this->infinite);
+
 	tinyxml2::XMLElement *tilesetElement = mapRoot->FirstChildElement("tileset");
 	tinyxml2::XMLElement *layerElement = mapRoot->FirstChildElement("layer");
 	tinyxml2::XMLElement *objectGroupElement = mapRoot->FirstChildElement("objectgroup");
@@ -107,42 +142,598 @@ tmx::Map::Map(const std::string &basePath, const std::string &filename)
 	}
 
 	while (layerElement != nullptr) {
-		this->layers.push_back(tmx::Layer(layerElement));
+		this->layers.push_back(tmx::Layer(layerElement, source, sourceSize));
 
 		layerElement = layerElement->NextSiblingElement("layer");
 	}
 
+	if (this->infinite) {
+		placeChunks();
+	}
+
+	// Objects move with the chunks.
+	int offsetX = -this->origin.x * static_cast<int>(this->tileWidth);
+	int offsetY = -this->origin.y * static_cast<int>(this->tileHeight);
+
 	while (objectGroupElement != nullptr) {
-		this->objectGroups.push_back(tmx::ObjectGroup(objectGroupElement));
+		this->objectGroups.push_back(
+		    tmx::ObjectGroup(objectGroupElement, offsetX, offsetY));
 
 		objectGroupElement = objectGroupElement->NextSiblingElement("objectgroup");
 	}
 
+	if (loadTextures) {
+		this->loadTextures();
+	}
+
+	std::vector<std::string> sources{mapPath};
+	for (const Tileset &tileset : this->tilesets) {
+		sources.push_back(tileset.sourcePath);
+	}
+
+	initLayers();
+	buildCollision(mapPath, sources);
+
+	// The cache would hold every chunk's gids.
+	if (!this->infinite && !tmx::saveMapCache(cachePath, *this, sources)) {
+		dbg::printMessage("Unable to write the map cache.", dbg::Urgency::WARNING);
+	}
+}
+
+tmx::Map &tmx::Map::operator=(Map &&other)
+{
+	if (this == &other) {
+		return *this;
+	}
+
+	// The worker holds pointers into the layers replaced below.
+	if (this->streamer) {
+		this->streamer->cancel();
+		this->streamer.reset();
+	}
+
+	this->version = other.version;
+	this->orientation = std::move(other.orientation);
+	this->renderOrder = std::move(other.renderOrder);
+	this->width = other.width;
+	this->height = other.height;
+	this->tileWidth = other.tileWidth;
+	this->tileHeight = other.tileHeight;
+	this->infinite = other.infinite;
+	this->origin = other.origin;
+	this->layers = std::move(other.layers);
+	this->tilesets = std::move(other.tilesets);
+	this->gidTable = std::move(other.gidTable);
+	this->objectGroups = std::move(other.objectGroups);
+	this->collisionLayers = std::move(other.collisionLayers);
+	this->chunkRequests = std::move(other.chunkRequests);
+	this->chunkResults = std::move(other.chunkResults);
+	this->changedChunks = std::move(other.changedChunks);
+	// Systems keep the map's address, a new revision tells them the collision changed.
+	this->collisionRevision = std::max(this->collisionRevision, other.collisionRevision) + 1;
+	// The other streamer's requests point into the layer buffer that moved along with it.
+	this->streamer = std::move(other.streamer);
+
+	return *this;
+}
+
+void tmx::Map::initLayers()
+{
+	// The table keeps the textures' addresses, textures still on their way are acquired now.
+	for (Tileset &tileset : this->tilesets) {
+		tileset.acquireTexture();
+	}
+
+	// Any layer can use tiles of any tileset, the table finds them by gid.
+	this->gidTable = std::make_shared<GidTable>();
+	this->gidTable->build(this->tilesets);
+
+	for (Layer &layer : this->layers) {
+		std::size_t tileCount = static_cast<std::size_t>(layer.width) * layer.height;
+
+		layer.gidTable = this->gidTable;
+		layer.tileWidth = this->tileWidth;
+		layer.tileHeight = this->tileHeight;
+		layer.streamed = this->infinite || tileCount > DEF_STREAM_TILES;
+		layer.init(); // Called after the gid table is set.
+	}
+}
+
+void tmx::Map::loadTextures()
+{
+	for (Tileset &tileset : this->tilesets) {
+		if (!tileset.loadTexture()) {
+			std::ostringstream errMsg;
+			errMsg << "Unable to load the tileset image " << tileset.imagePath << ".";
+
+			dbg::printMessage(errMsg.str().c_str(), dbg::Urgency::WARNING);
+		}
+	}
+}
+
+void tmx::Map::placeChunks()
+{
+	// Every layer is placed in the bounding box of all the layers' chunks
+
+	sf::IntRect bounds;
+
+	for (const Layer &layer : this->layers) {
+		sf::IntRect layerBounds = layer.getSourceBounds();
+
+		if (layerBounds.width == 0 || layerBounds.height == 0) {
+			continue;
+		}
+
+		if (bounds.width == 0 || bounds.height == 0) {
+			bounds = layerBounds;
+			continue;
+		}
+
+		int right =
+		    std::max(bounds.left + bounds.width, layerBounds.left + layerBounds.width);
+		int bottom =
+		    std::max(bounds.top + bounds.height, layerBounds.top + layerBounds.height);
+
+		bounds.left = std::min(bounds.left, layerBounds.left);
+		bounds.top = std::min(bounds.top, layerBounds.top);
+		bounds.width = right - bounds.left;
+		bounds.height = bottom - bounds.top;
+	}
+
+	this->origin = sf::Vector2i(bounds.left, bounds.top);
+	this->width = static_cast<unsigned int>(bounds.width);
+	this->height = static_cast<unsigned int>(bounds.height);
+
 	for (Layer &layer : this->layers) {
-		layer.sprite = sf::Sprite(this->tilesets[0].texture);
-		layer.tileset = this->tilesets[0];
-		layer.init(); // Called after tiles and sprites are set.
+		layer.placeChunks(this->origin, this->width, this->height);
+	}
+
+	std::ostringstream msg;
+	msg << "The infinite map's chunks cover " << this->width << "x" << this->height
+	    << " tiles starting at tile " << this->origin.x << ", " << this->origin.y << ".";
+	dbg::printMessage(msg.str().c_str(), dbg::Urgency::DEFAULT);
+}
+
+void tmx::Map::buildCollision(const std::string &mapPath,
+			      const std::vector<std::string> &sources)
+{
+	// One collision layer per category, merging is only redone when the map or one of its
+	// tilesets changed since the cache was written. The tilesets decide which gids are tiles.
+
+	std::uint64_t hash = this->infinite ? 0 : tmx::hashFiles(sources);
+	std::size_t rectCount = 0;
+
+	for (const Layer &layer : this->layers) {
+		if (!layer.isBlocking) {
+			continue;
+		}
+
+		bool known = std::any_of(
+		    this->collisionLayers.begin(), this->collisionLayers.end(),
+		    [&layer](const CollisionLayer &collision) {
+			    return collision.category == layer.collisionCategory;
+		    });
+
+		if (known) {
+			continue;
+		}
+
+		this->collisionLayers.push_back(CollisionLayer{});
+		CollisionLayer &collision = this->collisionLayers.back();
+		collision.category = layer.collisionCategory;
+
+		// Built per chunk as they stream in, see updateChunkCollision.
+		if (this->infinite) {
+			unsigned int size = Layer::CHUNK_SIZE;
+
+			collision.chunksX = (this->width + size - 1) / size;
+			collision.chunksY = (this->height + size - 1) / size;
+			collision.chunkSize =
+			    sf::Vector2f(static_cast<float>(size * this->tileWidth),
+					 static_cast<float>(size * this->tileHeight));
+			continue;
+		}
+
+		collision.bitmap.build(this->layers, collision.category,
+				       sf::Rect<unsigned int>(0, 0, this->width, this->height),
+				       this->tileWidth, this->tileHeight);
+
+		std::ostringstream cachePath;
+		cachePath << mapPath << "." << collision.category << ".geometry";
+
+		if (!collision.geometry.loadFromFile(cachePath.str(), hash, this->tileWidth,
+						     this->tileHeight)) {
+			collision.geometry.build(collision.bitmap, this->tileWidth,
+						 this->tileHeight);
+
+			if (hash != 0 && !collision.geometry.saveToFile(cachePath.str(), hash)) {
+				dbg::printMessage("Unable to cache the map's static geometry.",
+						  dbg::Urgency::WARNING);
+			}
+		}
+
+		rectCount += collision.geometry.getRects().size();
 	}
+
+	std::ostringstream msg;
+
+	if (this->infinite) {
+		msg << "Set up " << this->collisionLayers.size()
+		    << " collision layer(s), merged per chunk as they stream in.";
+	} else {
+		msg << "Merged blocking tiles into " << rectCount << " static rect(s) over "
+		    << this->collisionLayers.size() << " collision layer(s).";
+	}
+
+	dbg::printMessage(msg.str().c_str(), dbg::Urgency::DEFAULT);
 }
 
-void tmx::Map::draw(sf::RenderWindow &window, sf::Time deltaTime)
+void tmx::Map::draw(render::Target &target, sf::Time deltaTime)
 {
 	for (Layer &layer : this->layers) {
-		layer.draw(window, deltaTime);
+		layer.draw(target, deltaTime);
 	}
 }
 
-void tmx::Map::drawPosition(sf::RenderWindow &window, sf::Time deltaTime,
-			    const Transform &entityPos)
+void tmx::Map::drawRegion(render::Target &target, sf::Rect<float> region)
 {
 	for (Layer &layer : this->layers) {
-		layer.drawPosition(window, deltaTime, entityPos);
+		layer.drawRegion(target, region);
+	}
+}
+
+void tmx::Map::update(sf::Time deltaTime)
+{
+	for (Layer &layer : this->layers) {
+		layer.update(deltaTime);
+	}
+}
+
+void tmx::Map::useAtlas(const TextureAtlas &atlas)
+{
+	// Chunks being streamed would come back with the old texture rects.
+	if (this->streamer) {
+		this->streamer->cancel();
+	}
+
+	for (Tileset &tileset : this->tilesets) {
+		tileset.useAtlas(atlas);
+	}
+
+	// The texture rects moved, the layers share the rebuilt table.
+	this->gidTable->build(this->tilesets);
+
+	for (Layer &layer : this->layers) {
+		layer.buildChunks();
+	}
+}
+
+void tmx::Map::collectOverlay(sf::Rect<float> region, std::vector<render::Item> &items)
+{
+	for (Layer &layer : this->layers) {
+		layer.collectOverlay(region, items);
+	}
+}
+
+void tmx::Map::setStreamingView(sf::Rect<float> view)
+{
+	bool anyStreamed = std::any_of(this->layers.begin(), this->layers.end(),
+				       [](const Layer &layer) { return layer.streamed; });
+
+	if (!anyStreamed) {
+		return;
+	}
+
+	if (!this->streamer) {
+		this->streamer = std::make_unique<ChunkStreamer>();
+	}
+
+	this->streamer->collect(this->chunkResults);
+	for (ChunkStreamer::Result &result : this->chunkResults) {
+		this->layers[result.layerIndex].storeChunk(result.chunk, std::move(result.built));
+	}
+
+	// The view grown by a number of chunks on every side.
+	auto grow = [&view](const Layer &layer, int chunks) {
+		float w = static_cast<float>(Layer::CHUNK_SIZE * layer.tileWidth * chunks);
+		float h = static_cast<float>(Layer::CHUNK_SIZE * layer.tileHeight * chunks);
+
+		return sf::Rect<float>(view.left - w, view.top - h, view.width + w * 2.f,
+				       view.height + h * 2.f);
+	};
+
+	// Chunks are kept one ring further out than they're prefetched, so a camera moving back
+	// and forth over a chunk border doesn't rebuild them every time.
+	for (Layer &layer : this->layers) {
+		if (!layer.streamed) {
+			continue;
+		}
+
+		sf::Rect<float> keep = grow(layer, DEF_CHUNK_PREFETCH + 1);
+
+		// Unloading swaps the last resident chunk into the slot, so walk backwards.
+		const std::vector<unsigned int> &resident = layer.getResidentChunks();
+		for (std::size_t i = resident.size(); i-- > 0;) {
+			if (!keep.intersects(layer.getChunkBounds(resident[i]))) {
+				layer.unloadChunk(resident[i]);
+			}
+		}
+	}
+
+	if (getResidentChunkBytes() > DEF_CHUNK_BUDGET) {
+		unloadOverBudget(view);
+	}
+
+	updateChunkCollision();
+
+	// Without room left only the visible chunks are asked for, prefetching would just
+	// unload them again.
+	int ring = getResidentChunkBytes() < DEF_CHUNK_BUDGET ? DEF_CHUNK_PREFETCH : 0;
+	sf::Vector2f center(view.left + view.width / 2.f, view.top + view.height / 2.f);
+
+	this->chunkRequests.clear();
+
+	for (std::size_t layerIndex = 0; layerIndex < this->layers.size(); layerIndex++) {
+		const Layer &layer = this->layers[layerIndex];
+
+		if (!layer.streamed) {
+			continue;
+		}
+
+		sf::IntRect range = layer.regionToChunks(grow(layer, ring));
+
+		for (int y = range.top; y < range.top + range.height; y++) {
+			for (int x = range.left; x < range.left + range.width; x++) {
+				unsigned int index = y * layer.getChunksX() + x;
+
+				if (layer.isChunkResident(index)) {
+					continue;
+				}
+
+				// Nearest to the middle of the view first.
+				sf::FloatRect bounds = layer.getChunkBounds(index);
+				sf::Vector2f offset(bounds.left + bounds.width / 2.f - center.x,
+						    bounds.top + bounds.height / 2.f - center.y);
+
+				this->chunkRequests.push_back(ChunkStreamer::Request{
+				    &layer, layerIndex, index,
+				    offset.x * offset.x + offset.y * offset.y});
+			}
+		}
 	}
+
+	this->streamer->request(this->chunkRequests);
+}
+
+void tmx::Map::unloadOverBudget(sf::Rect<float> view)
+{
+	// Farthest chunks first, visible ones stay even if they alone are over the budget
+
+	sf::Vector2f center(view.left + view.width / 2.f, view.top + view.height / 2.f);
+	std::vector<ChunkStreamer::Request> candidates;
+
+	for (std::size_t layerIndex = 0; layerIndex < this->layers.size(); layerIndex++) {
+		Layer &layer = this->layers[layerIndex];
+
+		if (!layer.streamed) {
+			continue;
+		}
+
+		for (unsigned int index : layer.getResidentChunks()) {
+			sf::FloatRect bounds = layer.getChunkBounds(index);
+
+			if (view.intersects(bounds)) {
+				continue;
+			}
+
+			sf::Vector2f offset(bounds.left + bounds.width / 2.f - center.x,
+					    bounds.top + bounds.height / 2.f - center.y);
+
+			candidates.push_back(ChunkStreamer::Request{
+			    &layer, layerIndex, index, offset.x * offset.x + offset.y * offset.y});
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(),
+		  [](const ChunkStreamer::Request &a, const ChunkStreamer::Request &b) {
+			  return a.priority > b.priority;
+		  });
+
+	std::size_t residentBytes = getResidentChunkBytes();
+
+	for (const ChunkStreamer::Request &candidate : candidates) {
+		if (residentBytes <= DEF_CHUNK_BUDGET) {
+			break;
+		}
+
+		Layer &layer = this->layers[candidate.layerIndex];
+		std::size_t before = layer.getResidentBytes();
+
+		layer.unloadChunk(candidate.chunk);
+		residentBytes -= before - layer.getResidentBytes();
+	}
+}
+
+std::size_t tmx::Map::getResidentChunkBytes() const
+{
+	std::size_t bytes = 0;
+
+	for (const Layer &layer : this->layers) {
+		bytes += layer.getResidentBytes();
+	}
+
+	return bytes;
+}
+
+unsigned int tmx::Map::getCollisionRevision() const
+{
+	return this->collisionRevision;
 }
 
-void tmx::Map::drawRegion(sf::RenderWindow &window, sf::Time deltaTime, sf::Rect<float> region)
+void tmx::Map::updateChunkCollision()
 {
+	// Chunks of blocking layers that came or went since the last call are rebuilt from
+	// whatever is resident there now, chunks left without a blocking tile are dropped
+
+	this->changedChunks.clear();
+
 	for (Layer &layer : this->layers) {
-		layer.drawRegion(window, deltaTime, region);
+		layer.takeChangedChunks(this->changedChunks);
+	}
+
+	if (this->changedChunks.empty()) {
+		return;
+	}
+
+	std::sort(this->changedChunks.begin(), this->changedChunks.end());
+	this->changedChunks.erase(
+	    std::unique(this->changedChunks.begin(), this->changedChunks.end()),
+	    this->changedChunks.end());
+
+	unsigned int size = Layer::CHUNK_SIZE;
+
+	for (CollisionLayer &collision : this->collisionLayers) {
+		for (unsigned int index : this->changedChunks) {
+			sf::Rect<unsigned int> cells((index % collision.chunksX) * size,
+						     (index / collision.chunksX) * size, size,
+						     size);
+
+			CollisionLayer::Chunk chunk;
+			chunk.bitmap.build(this->layers, collision.category, cells, this->tileWidth,
+					   this->tileHeight);
+			chunk.geometry.build(chunk.bitmap, this->tileWidth, this->tileHeight);
+
+			if (chunk.geometry.getCells().empty()) {
+				collision.chunks.erase(index);
+			} else {
+				collision.chunks[index] = std::move(chunk);
+			}
+		}
+	}
+
+	this->collisionRevision++;
+}
+
+namespace
+{
+// Calls visit with every resident collision chunk the region touches until it returns true.
+template <typename Visit>
+bool visitChunks(const tmx::Map::CollisionLayer &collision, const sf::Rect<float> &region,
+		 Visit &&visit)
+{
+	sf::Vector2f size = collision.chunkSize;
+
+	int minX = static_cast<int>(std::floor(region.left / size.x));
+	int minY = static_cast<int>(std::floor(region.top / size.y));
+	int maxX = static_cast<int>(std::floor((region.left + region.width) / size.x));
+	int maxY = static_cast<int>(std::floor((region.top + region.height) / size.y));
+
+	minX = std::max(minX, 0);
+	minY = std::max(minY, 0);
+	maxX = std::min(maxX, static_cast<int>(collision.chunksX) - 1);
+	maxY = std::min(maxY, static_cast<int>(collision.chunksY) - 1);
+
+	for (int y = minY; y <= maxY; y++) {
+		for (int x = minX; x <= maxX; x++) {
+			auto found = collision.chunks.find(y * collision.chunksX + x);
+
+			if (found != collision.chunks.end() && visit(found->second)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+} // namespace
+
+bool tmx::Map::CollisionLayer::overlaps(const sf::Rect<float> &rect) const
+{
+	if (this->chunksX == 0) {
+		return this->bitmap.overlaps(rect);
+	}
+
+	return visitChunks(*this, rect,
+			   [&rect](const Chunk &chunk) { return chunk.bitmap.overlaps(rect); });
+}
+
+void tmx::Map::CollisionLayer::query(const sf::Rect<float> &region,
+				     std::vector<physics::AABB> &boxes) const
+{
+	// Appends the boxes of the merged rects overlapping the region
+
+	thread_local std::vector<std::uint32_t> hits;
+
+	auto append = [&](const StaticGeometry &geometry) {
+		hits.clear();
+		geometry.query(region, hits);
+
+		for (std::uint32_t index : hits) {
+			boxes.push_back(geometry.getTree().getBox(index));
+		}
+
+		return false;
+	};
+
+	if (this->chunksX == 0) {
+		append(this->geometry);
+		return;
+	}
+
+	visitChunks(*this, region,
+		    [&append](const Chunk &chunk) { return append(chunk.geometry); });
+}
+
+bool tmx::Map::CollisionLayer::raycast(sf::Vector2f origin, sf::Vector2f direction,
+				       float maxDistance, float &distance,
+				       sf::Vector2f &normal) const
+{
+	if (this->chunksX == 0) {
+		return this->bitmap.raycast(origin, direction, maxDistance, distance, normal);
+	}
+
+	// Each chunk the ray's bounds touch is walked on its own, the nearest hit wins. An
+	// endless ray looks at every resident chunk.
+	sf::Rect<float> reach(0.f, 0.f, this->chunksX * this->chunkSize.x,
+			      this->chunksY * this->chunkSize.y);
+
+	if (std::isfinite(maxDistance)) {
+		sf::Vector2f end = origin + direction * maxDistance;
+		reach = sf::Rect<float>(std::min(origin.x, end.x), std::min(origin.y, end.y),
+					std::abs(end.x - origin.x), std::abs(end.y - origin.y));
+	}
+
+	bool hit = false;
+
+	visitChunks(*this, reach, [&](const Chunk &chunk) {
+		float chunkDistance;
+		sf::Vector2f chunkNormal;
+
+		if (chunk.bitmap.raycast(origin, direction, maxDistance, chunkDistance,
+					 chunkNormal) &&
+		    (!hit || chunkDistance < distance)) {
+			hit = true;
+			distance = chunkDistance;
+			normal = chunkNormal;
+			maxDistance = chunkDistance;
+		}
+
+		return false;
+	});
+
+	return hit;
+}
+
+void tmx::Map::CollisionLayer::getRects(std::vector<sf::Rect<float>> &rects) const
+{
+	if (this->chunksX == 0) {
+		rects.insert(rects.end(), this->geometry.getRects().begin(),
+			     this->geometry.getRects().end());
+		return;
+	}
+
+	for (const auto &chunk : this->chunks) {
+		const std::vector<sf::Rect<float>> &chunkRects = chunk.second.geometry.getRects();
+		rects.insert(rects.end(), chunkRects.begin(), chunkRects.end());
 	}
 }
@@ -3,16 +3,24 @@
 
 #include <SFML/Graphics.hpp>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <tinyxml2.h>
+#include <unordered_map>
 #include <vector>
 
+#include "chunk-streamer.hpp"
+#include "collision-bitmap.hpp"
+#include "gid-table.hpp"
 #include "layer.hpp"
 #include "object-group.hpp"
+#include "static-geometry.hpp"
 #include "tileset.hpp"
 
-#include "../components/transform.hpp"
+#include "../physics/aabb.hpp"
+#include "../render/render_item.hpp"
+#include "../render/target.hpp"
 
 namespace tmx
 {
@@ -22,25 +30,97 @@ public:
 	Map()
 	{
 	}
-	explicit Map(const std::string &basePath, const std::string &filename);
+	// Without loadTextures the tilesets' textures stay empty, see MapLoader.
+	explicit Map(const std::string &basePath, const std::string &filename,
+		     bool loadTextures = true);
+
+	Map(Map &&) = default;
+	// Stops the streamer before the old layers go, its worker may be building one of them.
+	Map &operator=(Map &&other);
 
 	double version;
 	std::string orientation;
 	std::string renderOrder;
 
-	unsigned int width;
-	unsigned int height;
-	unsigned int tileWidth;
-	unsigned int tileHeight;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int tileWidth = 0;
+	unsigned int tileHeight = 0;
+
+	// Infinite maps are shifted so their top left chunk starts at tile 0, origin is the tile
+	// that was at the top left before. Only the chunks around the view are decoded.
+	bool infinite = false;
+	sf::Vector2i origin;
 
 	std::vector<Layer> layers;
 	std::vector<Tileset> tilesets;
+	// Every gid of the map resolved to its tileset, shared with the layers. It points into
+	// tilesets, which mustn't grow once the layers are initialised.
+	std::shared_ptr<GidTable> gidTable;
 	std::vector<ObjectGroup> objectGroups;
 
-	void draw(sf::RenderWindow &window, sf::Time deltaTime);
-	void drawPosition(sf::RenderWindow &window, sf::Time deltaTime, const Transform &entityPos);
-	void drawRegion(sf::RenderWindow &window, sf::Time deltaTime, sf::Rect<float> region);
+	// Blocking cells of the layers sharing a collision category.
+	struct CollisionLayer {
+		unsigned int category;
+		CollisionBitmap bitmap;
+		// The same cells merged into large rects, cached next to the map file.
+		StaticGeometry geometry;
+
+		// Infinite maps leave the two above empty. Each chunk with blocking tiles resident
+		// gets its own instead, keyed like the layers' chunks, so physics only sees the
+		// chunks around the view.
+		struct Chunk {
+			CollisionBitmap bitmap;
+			StaticGeometry geometry;
+		};
+
+		std::unordered_map<unsigned int, Chunk> chunks;
+		unsigned int chunksX = 0; // 0 unless the map is infinite.
+		unsigned int chunksY = 0;
+		sf::Vector2f chunkSize;
+
+		// The queries physics uses, they cover both cases.
+		bool overlaps(const sf::Rect<float> &rect) const;
+		void query(const sf::Rect<float> &region, std::vector<physics::AABB> &boxes) const;
+		bool raycast(sf::Vector2f origin, sf::Vector2f direction, float maxDistance,
+			     float &distance, sf::Vector2f &normal) const;
+		void getRects(std::vector<sf::Rect<float>> &rects) const;
+	};
+
+	// One per category in the order the layers use them, built once the layers load.
+	std::vector<CollisionLayer> collisionLayers;
+
+	void draw(render::Target &target, sf::Time deltaTime);
+	void drawRegion(render::Target &target, sf::Rect<float> region);
+	void collectOverlay(sf::Rect<float> region, std::vector<render::Item> &items);
+	void useAtlas(const TextureAtlas &atlas);
 	void update(sf::Time deltaTime);
+
+	// Keeps the chunks of streamed layers resident around the view, called once a frame
+	// before drawing. Chunks in the prefetch ring are built in the background, chunks past it
+	// are dropped, the farthest first while over the memory budget.
+	void setStreamingView(sf::Rect<float> view);
+	std::size_t getResidentChunkBytes() const;
+
+	// Changes whenever the collision of an infinite map's chunks comes or goes.
+	unsigned int getCollisionRevision() const;
+
+private:
+	void initLayers();
+	void loadTextures();
+	void placeChunks();
+	void buildCollision(const std::string &mapPath, const std::vector<std::string> &sources);
+	void unloadOverBudget(sf::Rect<float> view);
+	void updateChunkCollision();
+
+	std::vector<ChunkStreamer::Request> chunkRequests;
+	std::vector<ChunkStreamer::Result> chunkResults;
+	std::vector<unsigned int> changedChunks;
+	unsigned int collisionRevision = 0;
+
+	// Started by the first setStreamingView, declared last so it stops before the layers go
+	// when the map is destroyed. Moving into a map stops it first.
+	std::unique_ptr<ChunkStreamer> streamer;
 };
 } // namespace tmx
 
@@ -12,7 +12,11 @@ namespace tmx
 class ObjectGroup
 {
 public:
-	ObjectGroup(tinyxml2::XMLElement *objectGroupElement)
+	ObjectGroup()
+	{
+	}
+	// The offset in pixels is added to every object's position.
+	ObjectGroup(tinyxml2::XMLElement *objectGroupElement, int offsetX = 0, int offsetY = 0)
 	{
 		objectGroupElement->QueryUnsignedAttribute("id", &this->id);
 		this->name = objectGroupElement->Attribute("name");
@@ -20,7 +24,7 @@ public:
 		tinyxml2::XMLElement *objListElement =
 		    objectGroupElement->FirstChildElement("object");
 		while (objListElement != nullptr) {
-			this->objects.push_back(tmx::Object(objListElement));
+			this->objects.push_back(tmx::Object(objListElement, offsetX, offsetY));
 
 			objListElement = objListElement->NextSiblingElement("object");
 		}
@@ -1,6 +1,7 @@
 #ifndef TMX_PARSER_OBJECT_HPP
 #define TMX_PARSER_OBJECT_HPP
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <tinyxml2.h>
@@ -17,15 +18,23 @@ enum ObjectProperty {
 class Object
 {
 public:
-	Object(tinyxml2::XMLElement *objectElement)
+	Object()
+	{
+	}
+	Object(tinyxml2::XMLElement *objectElement, int offsetX = 0, int offsetY = 0)
 	{
 		objectElement->QueryUnsignedAttribute("id", &this->id);
 		this->name =
 		    objectElement->Attribute("name") ? objectElement->Attribute("name") : "";
 		this->type =
 		    objectElement->Attribute("type") ? objectElement->Attribute("type") : "";
-		objectElement->QueryUnsignedAttribute("x", &this->x);
-		objectElement->QueryUnsignedAttribute("y", &this->y);
+		// Objects of infinite maps can sit left of or above the origin until offset.
+		int posX = 0;
+		int posY = 0;
+		objectElement->QueryIntAttribute("x", &posX);
+		objectElement->QueryIntAttribute("y", &posY);
+		this->x = static_cast<unsigned int>(std::max(0, posX + offsetX));
+		this->y = static_cast<unsigned int>(std::max(0, posY + offsetY));
 		objectElement->QueryUnsignedAttribute("width", &this->width);
 		objectElement->QueryUnsignedAttribute("height", &this->height);
 		objectElement->QueryBoolAttribute("visible", &this->visible);
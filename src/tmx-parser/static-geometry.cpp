@@ -0,0 +1,198 @@
+#include "static-geometry.hpp"
+#include "../debug.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+void tmx::StaticGeometry::build(const CollisionBitmap &collision, unsigned int tileWidth,
+				unsigned int tileHeight)
+{
+	// Greedily grow each unclaimed blocking cell right, then down, into a maximal rect
+
+	unsigned int width = collision.getWidth();
+	unsigned int height = collision.getHeight();
+	sf::Vector2u origin = collision.getOrigin(); // The cells are kept in map cells.
+	std::vector<bool> claimed(static_cast<std::size_t>(width) * height, false);
+
+	auto isFree = [&](unsigned int x, unsigned int y) {
+		return collision.isBlocked(static_cast<int>(x), static_cast<int>(y)) &&
+		       !claimed[static_cast<std::size_t>(y) * width + x];
+	};
+
+	this->cells.clear();
+
+	for (unsigned int y = 0; y < height; y++) {
+		for (unsigned int x = 0; x < width; x++) {
+			if (!isFree(x, y)) {
+				continue;
+			}
+
+			unsigned int runWidth = 1;
+			while (x + runWidth < width && isFree(x + runWidth, y)) {
+				runWidth++;
+			}
+
+			unsigned int runHeight = 1;
+			for (bool grow = true; grow && y + runHeight < height;) {
+				for (unsigned int i = 0; i < runWidth; i++) {
+					if (!isFree(x + i, y + runHeight)) {
+						grow = false;
+						break;
+					}
+				}
+
+				if (grow) {
+					runHeight++;
+				}
+			}
+
+			for (unsigned int j = 0; j < runHeight; j++) {
+				for (unsigned int i = 0; i < runWidth; i++) {
+					std::size_t cell = static_cast<std::size_t>(y + j) * width;
+					claimed[cell + x + i] = true;
+				}
+			}
+
+			this->cells.push_back(sf::Rect<unsigned int>(
+			    x + origin.x, y + origin.y, runWidth, runHeight));
+		}
+	}
+
+	buildTree(tileWidth, tileHeight);
+}
+
+bool tmx::StaticGeometry::loadFromFile(const std::string &path, std::uint64_t hash,
+				       unsigned int tileWidth, unsigned int tileHeight)
+{
+	std::ifstream file(path);
+	if (!file || hash == 0) {
+		return false;
+	}
+
+	std::string keyword;
+	std::uint64_t fileHash = 0;
+	std::size_t count = 0;
+
+	if (!(file >> keyword >> std::hex >> fileHash >> std::dec >> count) ||
+	    keyword != "geometry" || fileHash != hash) {
+		return false;
+	}
+
+	std::vector<sf::Rect<unsigned int>> loaded;
+	loaded.reserve(count);
+
+	sf::Rect<unsigned int> rect;
+	while (file >> keyword >> rect.left >> rect.top >> rect.width >> rect.height) {
+		if (keyword != "rect") {
+			dbg::printMessage("Static geometry cache is malformed, rebuilding it.",
+					  dbg::Urgency::WARNING);
+			return false;
+		}
+
+		loaded.push_back(rect);
+	}
+
+	if (loaded.size() != count) {
+		return false;
+	}
+
+	setCells(std::move(loaded), tileWidth, tileHeight);
+
+	return true;
+}
+
+bool tmx::StaticGeometry::saveToFile(const std::string &path, std::uint64_t hash) const
+{
+	std::ofstream file(path);
+	if (!file) {
+		return false;
+	}
+
+	file << "geometry " << std::hex << hash << std::dec << " " << this->cells.size() << "\n";
+
+	for (const sf::Rect<unsigned int> &rect : this->cells) {
+		file << "rect " << rect.left << " " << rect.top << " " << rect.width << " "
+		     << rect.height << "\n";
+	}
+
+	return static_cast<bool>(file);
+}
+
+void tmx::StaticGeometry::setCells(std::vector<sf::Rect<unsigned int>> cells,
+				   unsigned int tileWidth, unsigned int tileHeight)
+{
+	this->cells = std::move(cells);
+	buildTree(tileWidth, tileHeight);
+}
+
+const std::vector<sf::Rect<unsigned int>> &tmx::StaticGeometry::getCells() const
+{
+	return this->cells;
+}
+
+void tmx::StaticGeometry::query(const sf::Rect<float> &region,
+				std::vector<std::uint32_t> &results) const
+{
+	this->tree.query(physics::AABB{.min = sf::Vector2f(region.left, region.top),
+				       .max = sf::Vector2f(region.left + region.width,
+							   region.top + region.height)},
+			 results);
+}
+
+const std::vector<sf::Rect<float>> &tmx::StaticGeometry::getRects() const
+{
+	return this->rects;
+}
+
+const physics::StaticAABBTree &tmx::StaticGeometry::getTree() const
+{
+	return this->tree;
+}
+
+void tmx::StaticGeometry::buildTree(unsigned int tileWidth, unsigned int tileHeight)
+{
+	float tw = static_cast<float>(tileWidth);
+	float th = static_cast<float>(tileHeight);
+
+	std::vector<physics::AABB> boxes;
+	boxes.reserve(this->cells.size());
+	this->rects.clear();
+
+	for (const sf::Rect<unsigned int> &cell : this->cells) {
+		sf::Rect<float> rect(cell.left * tw, cell.top * th, cell.width * tw,
+				     cell.height * th);
+
+		this->rects.push_back(rect);
+		boxes.push_back(physics::AABB{
+		    .min = sf::Vector2f(rect.left, rect.top),
+		    .max = sf::Vector2f(rect.left + rect.width, rect.top + rect.height),
+		});
+	}
+
+	this->tree.build(boxes);
+}
+
+std::uint64_t tmx::hashFiles(const std::vector<std::string> &paths)
+{
+	// One FNV-1a run over the files back to back
+
+	std::uint64_t hash = 14695981039346656037ull;
+	char buffer[4096];
+
+	for (const std::string &path : paths) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			return 0;
+		}
+
+		while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+			for (std::streamsize i = 0; i < file.gcount(); i++) {
+				hash ^= static_cast<unsigned char>(buffer[i]);
+				hash *= 1099511628211ull;
+			}
+		}
+	}
+
+	return hash;
+}
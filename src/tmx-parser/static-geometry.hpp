@@ -0,0 +1,53 @@
+#ifndef TMX_PARSER_STATIC_GEOMETRY_HPP
+#define TMX_PARSER_STATIC_GEOMETRY_HPP
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "collision-bitmap.hpp"
+
+#include "../physics/aabb_tree.hpp"
+
+namespace tmx
+{
+/* The blocking cells of a map merged into as few rectangles as a greedy sweep finds, with a
+ * static tree over them. A long wall ends up as one collider rather than one per tile. */
+class StaticGeometry
+{
+public:
+	void build(const CollisionBitmap &collision, unsigned int tileWidth,
+		   unsigned int tileHeight);
+
+	// The cache is only used when it was written for a map with the same hash.
+	bool loadFromFile(const std::string &path, std::uint64_t hash, unsigned int tileWidth,
+			  unsigned int tileHeight);
+	bool saveToFile(const std::string &path, std::uint64_t hash) const;
+
+	// Rects in cells, as build() produced them.
+	void setCells(std::vector<sf::Rect<unsigned int>> cells, unsigned int tileWidth,
+		      unsigned int tileHeight);
+	const std::vector<sf::Rect<unsigned int>> &getCells() const;
+
+	// Index into getRects() of every rect overlapping the region.
+	void query(const sf::Rect<float> &region, std::vector<std::uint32_t> &results) const;
+
+	const std::vector<sf::Rect<float>> &getRects() const;
+	const physics::StaticAABBTree &getTree() const;
+
+private:
+	void buildTree(unsigned int tileWidth, unsigned int tileHeight);
+
+	// In cells, the pixel rects are derived from these.
+	std::vector<sf::Rect<unsigned int>> cells;
+
+	std::vector<sf::Rect<float>> rects;
+	physics::StaticAABBTree tree;
+};
+
+// FNV-1a over the files' bytes in order, 0 if any can't be read.
+std::uint64_t hashFiles(const std::vector<std::string> &paths);
+} // namespace tmx
+
+#endif
@@ -0,0 +1,102 @@
+#include "texture-cache.hpp"
+#include "../debug.hpp"
+
+#include <sstream>
+
+std::shared_ptr<const sf::Texture> tmx::TextureCache::acquire(const std::string &path)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	std::shared_ptr<Slot> slot = findSlot(path);
+
+	// Shares ownership of the slot but points at its texture.
+	return std::shared_ptr<const sf::Texture>(slot, &slot->texture);
+}
+
+bool tmx::TextureCache::load(const std::string &path)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	std::shared_ptr<Slot> slot = findSlot(path);
+
+	if (slot->loaded) {
+		return true;
+	}
+
+	slot->loaded = slot->texture.loadFromFile(path);
+
+	if (slot->loaded) {
+		countCreated(path);
+	}
+
+	return slot->loaded;
+}
+
+bool tmx::TextureCache::load(const std::string &path, const sf::Image &image)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	std::shared_ptr<Slot> slot = findSlot(path);
+
+	if (slot->loaded) {
+		return true;
+	}
+
+	slot->loaded = slot->texture.loadFromImage(image);
+
+	if (slot->loaded) {
+		countCreated(path);
+	}
+
+	return slot->loaded;
+}
+
+unsigned int tmx::TextureCache::getCreatedCount() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->createdCount;
+}
+
+std::size_t tmx::TextureCache::getEntryCount() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->slots.size();
+}
+
+tmx::TextureCache &tmx::TextureCache::shared()
+{
+	// Only weak references live here, so it doesn't matter when this is destroyed.
+	static TextureCache cache;
+	return cache;
+}
+
+std::shared_ptr<tmx::TextureCache::Slot> tmx::TextureCache::findSlot(const std::string &path)
+{
+	auto found = this->slots.find(path);
+	if (found != this->slots.end()) {
+		if (std::shared_ptr<Slot> slot = found->second.lock()) {
+			return slot;
+		}
+	}
+
+	// Drop the images no tileset holds anymore, so unloaded maps don't leave entries behind.
+	for (auto it = this->slots.begin(); it != this->slots.end();) {
+		if (it->second.expired()) {
+			it = this->slots.erase(it);
+		} else {
+			it++;
+		}
+	}
+
+	std::shared_ptr<Slot> slot = std::make_shared<Slot>();
+	this->slots[path] = slot;
+
+	return slot;
+}
+
+void tmx::TextureCache::countCreated(const std::string &path)
+{
+	this->createdCount++;
+
+	std::ostringstream msg;
+	msg << "Uploaded tileset texture " << path << " (" << this->createdCount
+	    << " tileset textures uploaded so far).";
+	dbg::printMessage(msg.str().c_str(), dbg::Urgency::DEFAULT);
+}
@@ -0,0 +1,47 @@
+#ifndef TMX_PARSER_TEXTURE_CACHE_HPP
+#define TMX_PARSER_TEXTURE_CACHE_HPP
+
+#include <SFML/Graphics.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace tmx
+{
+/* Tileset textures by image path. Every tileset using an image, in any map, holds the same
+ * texture and it is only uploaded once. The cache doesn't own the textures, they go away with
+ * the last tileset using them. */
+class TextureCache
+{
+public:
+	// The texture for the image at path, empty until one of the loads below.
+	std::shared_ptr<const sf::Texture> acquire(const std::string &path);
+
+	// Neither upload again when the texture was already loaded, by another map for instance.
+	bool load(const std::string &path);
+	bool load(const std::string &path, const sf::Image &image);
+
+	// How many textures were uploaded so far.
+	unsigned int getCreatedCount() const;
+	// How many images have an entry, entries of released textures are dropped on the next miss.
+	std::size_t getEntryCount() const;
+
+	static TextureCache &shared();
+
+private:
+	struct Slot {
+		sf::Texture texture;
+		bool loaded = false;
+	};
+
+	std::shared_ptr<Slot> findSlot(const std::string &path);
+	void countCreated(const std::string &path);
+
+	mutable std::mutex mutex;
+	std::map<std::string, std::weak_ptr<Slot>> slots;
+	unsigned int createdCount = 0;
+};
+} // namespace tmx
+
+#endif
@@ -1,10 +0,0 @@
-#ifndef TMX_PARSER_TILE_HPP
-#define TMX_PARSER_TILE_HPP
-
-struct MapTile {
-	unsigned int x;
-	unsigned int y;
-	bool isBlocking;
-};
-
-#endif
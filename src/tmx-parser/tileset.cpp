@@ -4,6 +4,7 @@ tmx::Tileset::Tileset(const std::string &basePath, const std::string &filename,
     : firstGid(firstGid), source(filename)
 {
 	std::string newPath = basePath + "/resources/maps/" + filename;
+	this->sourcePath = newPath;
 
 	tinyxml2::XMLDocument doc;
 	doc.LoadFile(newPath.c_str());
@@ -24,5 +25,109 @@ tmx::Tileset::Tileset(const std::string &basePath, const std::string &filename,
 
 	std::cout << newPath << std::endl;
 
-	this->texture.loadFromFile(newPath);
+	this->imagePath = newPath;
+
+	tinyxml2::XMLElement *tileElement = mapRoot->FirstChildElement("tile");
+
+	while (tileElement != nullptr) {
+		tinyxml2::XMLElement *animationElement =
+		    tileElement->FirstChildElement("animation");
+		unsigned int tileId = 0;
+
+		if (animationElement != nullptr &&
+		    tileElement->QueryUnsignedAttribute("id", &tileId) == tinyxml2::XML_SUCCESS) {
+			TileAnimation animation{
+			    static_cast<unsigned int>(this->animationFrames.size()), 0, 0};
+
+			tinyxml2::XMLElement *frameElement =
+			    animationElement->FirstChildElement("frame");
+
+			while (frameElement != nullptr) {
+				TileFrame frame{0, 0};
+				frameElement->QueryUnsignedAttribute("tileid", &frame.localId);
+				frameElement->QueryUnsignedAttribute("duration", &frame.duration);
+
+				// A zero length frame would never be shown.
+				if (frame.duration > 0) {
+					this->animationFrames.push_back(frame);
+					animation.frameCount++;
+					animation.totalDuration += frame.duration;
+				}
+
+				frameElement = frameElement->NextSiblingElement("frame");
+			}
+
+			if (animation.frameCount > 0) {
+				if (this->animationLookup.size() <= tileId) {
+					this->animationLookup.resize(
+					    std::max(tileId + 1, this->tileCount), -1);
+				}
+
+				this->animationLookup[tileId] = this->animations.size();
+				this->animations.push_back(animation);
+			}
+		}
+
+		tileElement = tileElement->NextSiblingElement("tile");
+	}
+}
+
+void tmx::Tileset::acquireTexture()
+{
+	if (!this->texture) {
+		this->texture = TextureCache::shared().acquire(this->imagePath);
+	}
+}
+
+bool tmx::Tileset::loadTexture()
+{
+	acquireTexture();
+	return TextureCache::shared().load(this->imagePath);
+}
+
+bool tmx::Tileset::loadTexture(const sf::Image &image)
+{
+	acquireTexture();
+	return TextureCache::shared().load(this->imagePath, image);
+}
+
+unsigned int tmx::Tileset::getAnimationFrame(int animation, sf::Time time,
+					     sf::Time &nextChange) const
+{
+	// Returns the local id shown at the given time and when it will next change
+
+	const TileAnimation &anim = this->animations[animation];
+
+	sf::Int64 cycle = static_cast<sf::Int64>(anim.totalDuration) * 1000;
+	sf::Int64 elapsed = time.asMicroseconds() % cycle;
+	sf::Int64 cycleStart = time.asMicroseconds() - elapsed;
+	sf::Int64 frameEnd = 0;
+
+	for (unsigned int i = 0; i < anim.frameCount; i++) {
+		const TileFrame &frame = this->animationFrames[anim.firstFrame + i];
+		frameEnd += static_cast<sf::Int64>(frame.duration) * 1000;
+
+		if (elapsed < frameEnd) {
+			nextChange = sf::microseconds(cycleStart + frameEnd);
+			return frame.localId;
+		}
+	}
+
+	nextChange = sf::microseconds(cycleStart + cycle);
+	return this->animationFrames[anim.firstFrame].localId;
+}
+
+void tmx::Tileset::useAtlas(const TextureAtlas &atlas)
+{
+	const TextureAtlas::Region *region = atlas.find(this->imagePath);
+
+	if (region == nullptr) {
+		return;
+	}
+
+	this->atlasPage = &atlas.getPage(region->page);
+	this->atlasOffset = sf::Vector2i(region->rect.left, region->rect.top);
+
+	// Drawing only uses the page from now on, the texture goes once no other map uses it.
+	this->texture.reset();
 }
@@ -4,12 +4,27 @@
 #include <SFML/Graphics.hpp>
 #include <algorithm>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <tinyxml2.h>
 #include <vector>
 
+#include "../texture_atlas.hpp"
+#include "texture-cache.hpp"
+
 namespace tmx
 {
+struct TileFrame {
+	unsigned int localId;
+	unsigned int duration; // Milliseconds
+};
+
+struct TileAnimation {
+	unsigned int firstFrame; // Index into Tileset::animationFrames
+	unsigned int frameCount;
+	unsigned int totalDuration;
+};
+
 class Tileset
 {
 public:
@@ -20,6 +35,7 @@ public:
 
 	int firstGid;
 	std::string source;
+	std::string sourcePath; // The .tsx file source was resolved to.
 
 	double version;
 	std::string name;
@@ -28,7 +44,53 @@ public:
 	unsigned int tileCount;
 	unsigned int columns;
 
-	sf::Texture texture;
+	// Shared with every tileset using the same image, see TextureCache. Empty until
+	// loadTexture, MapLoader uploads it from an image decoded on another thread.
+	std::shared_ptr<const sf::Texture> texture;
+	std::string imagePath;
+
+	// The texture can be acquired before it is loaded, its address doesn't change.
+	void acquireTexture();
+	bool loadTexture();
+	bool loadTexture(const sf::Image &image);
+
+	// Set when the tileset image was packed into a texture atlas, which releases texture.
+	const sf::Texture *atlasPage = nullptr;
+	sf::Vector2i atlasOffset;
+
+	// Frames of every <animation> in the tileset, stored back to back.
+	std::vector<TileFrame> animationFrames;
+	std::vector<TileAnimation> animations;
+	// Local tile id to index in animations, -1 for static tiles.
+	std::vector<int> animationLookup;
+
+	void useAtlas(const TextureAtlas &atlas);
+
+	int getAnimation(int localId) const
+	{
+		if (localId < 0 || localId >= static_cast<int>(this->animationLookup.size())) {
+			return -1;
+		}
+
+		return this->animationLookup[localId];
+	}
+
+	unsigned int getAnimationFrame(int animation, sf::Time time, sf::Time &nextChange) const;
+
+	sf::IntRect getTextureRect(int localId) const
+	{
+		int cols = static_cast<int>(this->columns);
+		int tw = static_cast<int>(this->tileWidth);
+		int th = static_cast<int>(this->tileHeight);
+
+		return sf::IntRect((localId % cols) * tw + this->atlasOffset.x,
+				   (localId / cols) * th + this->atlasOffset.y, tw, th);
+	}
+
+	const sf::Texture &getTexture() const
+	{
+		return this->atlasPage ? *this->atlasPage : *this->texture;
+	}
 };
 } // namespace tmx
 
@@ -0,0 +1,90 @@
+#include "physics/aabb_batch.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+const std::size_t BOXES = 4096;
+const int ROUNDS = 8;
+
+// Prints the million box pairs tested per second, every query box against every box.
+template <typename Test>
+void measure(const char *name, const std::vector<physics::AABB> &queries, Test test)
+{
+	std::size_t hitCount = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	for (int round = 0; round < ROUNDS; round++) {
+		for (const physics::AABB &query : queries) {
+			hitCount += test(query);
+		}
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	double pairs = static_cast<double>(queries.size()) * BOXES * ROUNDS;
+
+	// The hits are printed so the work can't be optimised away.
+	std::printf("%-22s %10.1f Mpairs/s (%zu hits)\n", name, pairs / elapsed.count() / 1e6,
+		    hitCount);
+}
+} // namespace
+
+int main()
+{
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> position(0.f, 4000.f);
+	std::uniform_real_distribution<float> size(4.f, 64.f);
+
+	auto randomBox = [&]() {
+		sf::Vector2f min(position(random), position(random));
+		sf::Vector2f extent(size(random), size(random));
+		return physics::AABB{.min = min, .max = min + extent};
+	};
+
+	physics::AABBBatch batch;
+	std::vector<physics::AABB> boxes;
+	std::vector<physics::AABB> queries;
+
+	for (std::size_t i = 0; i < BOXES; i++) {
+		boxes.push_back(randomBox());
+		batch.push(boxes.back());
+		queries.push_back(randomBox());
+	}
+
+	std::vector<std::uint32_t> hits;
+
+	auto kernel = [&](physics::OverlapKernel overlap) {
+		return [&batch, &hits, overlap](const physics::AABB &query) {
+			hits.clear();
+			overlap(batch, 0, batch.size(), query, hits);
+			return hits.size();
+		};
+	};
+
+	// What the narrowphase did before the batches, one sf::Rect intersection per pair.
+	measure("sf::Rect::intersects", queries, [&boxes](const physics::AABB &query) {
+		sf::FloatRect queryRect(query.min, query.max - query.min);
+		std::size_t count = 0;
+
+		for (const physics::AABB &box : boxes) {
+			count += queryRect.intersects(sf::FloatRect(box.min, box.max - box.min));
+		}
+
+		return count;
+	});
+
+	measure("scalar", queries, kernel(physics::detail::overlapScalar));
+
+#ifdef PHYSICS_AABB_BATCH_X86
+	measure("sse2", queries, kernel(physics::detail::overlapSSE2));
+
+	if (__builtin_cpu_supports("avx2")) {
+		measure("avx2", queries, kernel(physics::detail::overlapAVX2));
+	}
+#endif
+
+	return 0;
+}
@@ -0,0 +1,26 @@
+#include "physics_scene.hpp"
+
+#include "systems/box2d_physics_system.hpp"
+#include "systems/rigid_physics_system.hpp"
+
+#include <cstdio>
+
+// The pile scene through both physics backends at 1k, 10k and 50k bodies, on one thread each.
+int main()
+{
+	std::printf("%10s %16s %16s\n", "bodies", "rigid ms/tick", "box2d ms/tick");
+
+	for (std::size_t bodies : {1000, 10000, 50000}) {
+		unsigned int ticks = bodies > 10000 ? 20 : 60;
+
+		PhysicsScene<RigidPhysicsSystem> rigid(bodies);
+		double rigidMs = rigid.measure(ticks);
+
+		PhysicsScene<Box2DPhysicsSystem> box2d(bodies);
+		double box2dMs = box2d.measure(ticks);
+
+		std::printf("%10zu %16.3f %16.3f\n", bodies, rigidMs, box2dMs);
+	}
+
+	return 0;
+}
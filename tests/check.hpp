@@ -0,0 +1,47 @@
+#ifndef TESTS_CHECK_HPP
+#define TESTS_CHECK_HPP
+
+#include <iostream>
+
+/* Just enough to write the checks with. A failed CHECK prints where it failed and carries on,
+ * main returns check::result() so ctest sees the failures. */
+namespace check
+{
+inline int &failures()
+{
+	static int count = 0;
+	return count;
+}
+
+inline int result()
+{
+	if (failures() > 0) {
+		std::cerr << failures() << " check(s) failed.\n";
+		return 1;
+	}
+
+	return 0;
+}
+} // namespace check
+
+#define CHECK(condition)                                                                   \
+	do {                                                                               \
+		if (!(condition)) {                                                        \
+			std::cerr << __FILE__ << ":" << __LINE__                           \
+				  << ": check failed: " #condition "\n";                   \
+			check::failures()++;                                               \
+		}                                                                          \
+	} while (false)
+
+#define CHECK_EQ(actual, expected)                                                         \
+	do {                                                                               \
+		auto checkActual = (actual);                                               \
+		auto checkExpected = (expected);                                           \
+		if (!(checkActual == checkExpected)) {                                     \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": " #actual " is "    \
+				  << checkActual << ", expected " << checkExpected << "\n"; \
+			check::failures()++;                                               \
+		}                                                                          \
+	} while (false)
+
+#endif
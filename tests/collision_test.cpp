@@ -0,0 +1,127 @@
+#include "check.hpp"
+#include "fixtures.hpp"
+
+#include "physics/spatial_hash_grid.hpp"
+#include "tmx-parser/map.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+// The grid finds exactly what testing every box against every other finds.
+void checkBroadphase()
+{
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> position(0.f, 2000.f);
+	std::uniform_real_distribution<float> size(2.f, 150.f);
+
+	std::vector<physics::AABB> boxes;
+	std::vector<CollisionFilter> filters;
+	physics::SpatialHashGrid grid;
+
+	for (std::uint32_t id = 0; id < 2000; id++) {
+		sf::Vector2f min(position(random), position(random));
+		sf::Vector2f extent(size(random), size(random));
+		physics::AABB box{.min = min, .max = min + extent};
+
+		// Three categories, every fifth box only collides with the first.
+		CollisionFilter filter{.category = 1u << (id % 3), .mask = id % 5 == 0 ? 1u : ~0u};
+
+		boxes.push_back(box);
+		filters.push_back(filter);
+		grid.insert(id, box, filter);
+	}
+
+	// Half of them move, some far enough to change every cell they cover.
+	for (std::uint32_t id = 0; id < boxes.size(); id += 2) {
+		sf::Vector2f offset(position(random), position(random));
+		offset = offset / 10.f - sf::Vector2f(100.f, 100.f);
+		boxes[id].min += offset;
+		boxes[id].max += offset;
+		grid.update(id, boxes[id], filters[id]);
+	}
+
+	std::vector<std::uint32_t> found;
+	std::size_t pairs = 0;
+
+	for (std::uint32_t id = 0; id < boxes.size(); id++) {
+		found.clear();
+		grid.query(boxes[id], filters[id], found);
+		std::sort(found.begin(), found.end());
+
+		std::vector<std::uint32_t> expected;
+		for (std::uint32_t other = 0; other < boxes.size(); other++) {
+			if (physics::AABBvsAABB(boxes[id], boxes[other]) &&
+			    shouldCollide(filters[id], filters[other])) {
+				expected.push_back(other);
+			}
+		}
+
+		CHECK(found == expected);
+		pairs += expected.size();
+	}
+
+	// The boxes are spread enough that most don't touch anything, but not all.
+	CHECK(pairs > boxes.size());
+}
+
+// Blocking tiles merge into one rect per wall, block and leg of an L.
+void checkMergedRects()
+{
+	std::string base = fixture::makeBase();
+	fixture::writeTileset(base, "walls", 4, 4, 16);
+
+	std::vector<unsigned int> walls(16 * 16, 0);
+	auto block = [&walls](unsigned int x, unsigned int y) { walls[y * 16 + x] = 1; };
+
+	for (unsigned int x = 0; x < 16; x++) {
+		block(x, 0);
+	}
+	for (unsigned int y = 2; y < 10; y++) {
+		block(0, y);
+	}
+	for (unsigned int y = 5; y < 8; y++) {
+		for (unsigned int x = 5; x < 8; x++) {
+			block(x, y);
+		}
+	}
+	for (unsigned int y = 9; y < 12; y++) {
+		block(10, y);
+	}
+	for (unsigned int x = 10; x < 14; x++) {
+		block(x, 12);
+	}
+
+	fixture::LayerSpec layer{"walls", walls};
+	layer.blocking = true;
+
+	std::string filename =
+	    fixture::writeMap(base, "walls", 16, 16, 16, {{"walls", 1}}, {layer});
+	tmx::Map map(base, filename, false);
+
+	CHECK_EQ(map.collisionLayers.size(), std::size_t(1));
+
+	std::vector<sf::Rect<float>> rects;
+	map.collisionLayers[0].getRects(rects);
+
+	float area = 0.f;
+	for (const sf::Rect<float> &rect : rects) {
+		area += rect.width * rect.height;
+	}
+
+	CHECK_EQ(rects.size(), std::size_t(5));
+	CHECK_EQ(area, 40.f * 16.f * 16.f);
+
+	fixture::removeBase(base);
+}
+} // namespace
+
+int main()
+{
+	checkBroadphase();
+	checkMergedRects();
+
+	return check::result();
+}
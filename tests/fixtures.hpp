@@ -0,0 +1,224 @@
+#ifndef TESTS_FIXTURES_HPP
+#define TESTS_FIXTURES_HPP
+
+#include <SFML/Graphics.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <zlib.h>
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* Maps, tilesets and images written on the fly, laid out the way the game expects them:
+ * maps in resources/maps, tilesets and their images in resources/tilesets. */
+namespace fixture
+{
+// How writeMap stores the layers' gids, the ways Tiled can save them.
+enum class Encoding { CSV, BASE64, ZLIB, GZIP };
+
+struct TilesetRef {
+	std::string name;
+	unsigned int firstGid;
+};
+
+struct LayerSpec {
+	std::string name;
+	std::vector<unsigned int> gids; // Row by row, width * height of them.
+	bool blocking = false;
+	bool overlay = false;
+};
+
+// A fresh scratch directory to pass as a map's base path.
+inline std::string makeBase()
+{
+	boost::filesystem::path base = boost::filesystem::temp_directory_path() /
+				       boost::filesystem::unique_path("engine-test-%%%%-%%%%-%%%%");
+
+	boost::filesystem::create_directories(base / "resources" / "maps");
+	boost::filesystem::create_directories(base / "resources" / "tilesets");
+
+	return base.string();
+}
+
+inline void removeBase(const std::string &base)
+{
+	boost::system::error_code error;
+	boost::filesystem::remove_all(base, error);
+}
+
+inline void writeFile(const std::string &path, const std::string &contents)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file << contents;
+}
+
+// A columns x rows sheet of square tiles in resources/tilesets, as name.tsx and name.png.
+inline void writeTileset(const std::string &base, const std::string &name, unsigned int columns,
+			 unsigned int rows, unsigned int tileSize,
+			 sf::Color color = sf::Color::White)
+{
+	std::string dir = base + "/resources/tilesets/";
+
+	sf::Image image;
+	image.create(columns * tileSize, rows * tileSize, color);
+	image.saveToFile(dir + name + ".png");
+
+	std::ostringstream tsx;
+	tsx << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	    << "<tileset version=\"1.2\" name=\"" << name << "\" tilewidth=\"" << tileSize
+	    << "\" tileheight=\"" << tileSize << "\" tilecount=\"" << columns * rows
+	    << "\" columns=\"" << columns << "\">\n"
+	    << " <image source=\"" << name << ".png\" width=\"" << columns * tileSize
+	    << "\" height=\"" << rows * tileSize << "\"/>\n"
+	    << "</tileset>\n";
+
+	writeFile(dir + name + ".tsx", tsx.str());
+}
+
+inline std::string csvData(const std::vector<unsigned int> &gids, unsigned int width)
+{
+	std::string text = "\n";
+
+	for (std::size_t i = 0; i < gids.size(); i++) {
+		text += std::to_string(gids[i]);
+
+		if (i + 1 < gids.size()) {
+			text += ",";
+		}
+
+		if ((i + 1) % width == 0) {
+			text += "\n";
+		}
+	}
+
+	return text;
+}
+
+inline std::string base64(const std::vector<std::uint8_t> &bytes)
+{
+	static const char digits[] =
+	    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	std::string text;
+	text.reserve((bytes.size() + 2) / 3 * 4);
+
+	for (std::size_t i = 0; i < bytes.size(); i += 3) {
+		std::uint32_t group = static_cast<std::uint32_t>(bytes[i]) << 16;
+		std::size_t left = bytes.size() - i;
+
+		if (left > 1) {
+			group |= static_cast<std::uint32_t>(bytes[i + 1]) << 8;
+		}
+
+		if (left > 2) {
+			group |= bytes[i + 2];
+		}
+
+		text += digits[(group >> 18) & 0x3F];
+		text += digits[(group >> 12) & 0x3F];
+		text += left > 1 ? digits[(group >> 6) & 0x3F] : '=';
+		text += left > 2 ? digits[group & 0x3F] : '=';
+	}
+
+	return text;
+}
+
+// Deflates bytes with a zlib header, or a gzip one with gzip set.
+inline std::vector<std::uint8_t> compress(const std::vector<std::uint8_t> &bytes, bool gzip)
+{
+	z_stream stream{};
+	deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, gzip ? 15 + 16 : 15, 8,
+		     Z_DEFAULT_STRATEGY);
+
+	std::vector<std::uint8_t> compressed(deflateBound(&stream, bytes.size()) + 32);
+
+	stream.next_in = const_cast<Bytef *>(bytes.data());
+	stream.avail_in = static_cast<uInt>(bytes.size());
+	stream.next_out = compressed.data();
+	stream.avail_out = static_cast<uInt>(compressed.size());
+
+	deflate(&stream, Z_FINISH);
+	compressed.resize(stream.total_out);
+	deflateEnd(&stream);
+
+	return compressed;
+}
+
+// A layer's <data> element, the gids stored the way encoding says.
+inline std::string dataElement(const std::vector<unsigned int> &gids, unsigned int width,
+			       Encoding encoding)
+{
+	if (encoding == Encoding::CSV) {
+		return "<data encoding=\"csv\">" + csvData(gids, width) + "</data>";
+	}
+
+	// Little endian 32 bit gids.
+	std::vector<std::uint8_t> bytes;
+	bytes.reserve(gids.size() * 4);
+
+	for (unsigned int gid : gids) {
+		for (int shift = 0; shift < 32; shift += 8) {
+			bytes.push_back(static_cast<std::uint8_t>(gid >> shift));
+		}
+	}
+
+	if (encoding == Encoding::BASE64) {
+		return "<data encoding=\"base64\">\n" + base64(bytes) + "\n</data>";
+	}
+
+	bool gzip = encoding == Encoding::GZIP;
+
+	return std::string("<data encoding=\"base64\" compression=\"") +
+	       (gzip ? "gzip" : "zlib") + "\">\n" + base64(compress(bytes, gzip)) + "\n</data>";
+}
+
+// A finite map in resources/maps, returns the filename to give tmx::Map.
+inline std::string writeMap(const std::string &base, const std::string &name, unsigned int width,
+			    unsigned int height, unsigned int tileSize,
+			    const std::vector<TilesetRef> &tilesets,
+			    const std::vector<LayerSpec> &layers,
+			    Encoding encoding = Encoding::CSV)
+{
+	std::ostringstream tmx;
+	tmx << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	    << "<map version=\"1.2\" orientation=\"orthogonal\" renderorder=\"right-down\" width=\""
+	    << width << "\" height=\"" << height << "\" tilewidth=\"" << tileSize
+	    << "\" tileheight=\"" << tileSize << "\" infinite=\"0\">\n";
+
+	for (const TilesetRef &tileset : tilesets) {
+		tmx << " <tileset firstgid=\"" << tileset.firstGid << "\" source=\"../tilesets/"
+		    << tileset.name << ".tsx\"/>\n";
+	}
+
+	for (std::size_t i = 0; i < layers.size(); i++) {
+		const LayerSpec &layer = layers[i];
+
+		tmx << " <layer id=\"" << i + 1 << "\" name=\"" << layer.name << "\" width=\""
+		    << width << "\" height=\"" << height << "\">\n";
+
+		if (layer.blocking || layer.overlay) {
+			tmx << "  <properties>\n"
+			    << "   <property name=\"isBlocking\" type=\"bool\" value=\""
+			    << (layer.blocking ? "true" : "false") << "\"/>\n"
+			    << "   <property name=\"isOverlay\" type=\"bool\" value=\""
+			    << (layer.overlay ? "true" : "false") << "\"/>\n"
+			    << "  </properties>\n";
+		}
+
+		tmx << "  " << dataElement(layer.gids, width, encoding) << "\n"
+		    << " </layer>\n";
+	}
+
+	tmx << "</map>\n";
+
+	std::string filename = "resources/maps/" + name + ".tmx";
+	writeFile(base + "/" + filename, tmx.str());
+
+	return filename;
+}
+} // namespace fixture
+
+#endif
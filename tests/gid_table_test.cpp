@@ -0,0 +1,77 @@
+#include "check.hpp"
+#include "fixtures.hpp"
+
+#include "tmx-parser/layer-data.hpp"
+#include "tmx-parser/map.hpp"
+
+#include <vector>
+
+namespace
+{
+// The tileset, local id and texture rect a gid should resolve to.
+void checkEntry(const tmx::Map &map, int gid, unsigned int tilesetIndex, int localId,
+		const sf::IntRect &textureRect)
+{
+	const tmx::GidTable::Entry &entry = (*map.gidTable)[gid];
+	const tmx::Tileset &tileset = map.tilesets[tilesetIndex];
+
+	CHECK(entry.tileset == &tileset);
+	CHECK_EQ(entry.tilesetIndex, tilesetIndex);
+	CHECK_EQ(entry.localId, localId);
+	CHECK(entry.textureRect == textureRect);
+	CHECK(entry.texture == &tileset.getTexture());
+}
+} // namespace
+
+// Three tilesets of different shapes and tile sizes, with a gap in the gids between the last two.
+int main()
+{
+	std::string base = fixture::makeBase();
+	fixture::writeTileset(base, "grass", 4, 4, 16);
+	fixture::writeTileset(base, "rocks", 2, 3, 16);
+	fixture::writeTileset(base, "water", 8, 2, 8);
+
+	// grass is gids 1-16, rocks 17-22 and water 30-45.
+	std::vector<unsigned int> gids{1, 16, 17, 22, 30, 45, 0, 0x80000000u | 17u};
+	std::vector<fixture::TilesetRef> tilesets{{"grass", 1}, {"rocks", 17}, {"water", 30}};
+	std::string filename =
+	    fixture::writeMap(base, "tables", 8, 1, 16, tilesets, {{"ground", gids}});
+
+	tmx::Map map(base, filename, false);
+
+	CHECK_EQ(map.tilesets.size(), std::size_t(3));
+	CHECK(map.gidTable != nullptr);
+
+	if (map.tilesets.size() == 3 && map.gidTable) {
+		checkEntry(map, 1, 0, 0, sf::IntRect(0, 0, 16, 16));
+		checkEntry(map, 16, 0, 15, sf::IntRect(48, 48, 16, 16));
+		checkEntry(map, 17, 1, 0, sf::IntRect(0, 0, 16, 16));
+		checkEntry(map, 22, 1, 5, sf::IntRect(16, 32, 16, 16));
+		checkEntry(map, 30, 2, 0, sf::IntRect(0, 0, 8, 8));
+		checkEntry(map, 45, 2, 15, sf::IntRect(56, 8, 8, 8));
+
+		// Gid 0, the gap between rocks and water and anything past water aren't tiles.
+		for (int gid : {-1, 0, 23, 29, 46, 1000}) {
+			CHECK(!map.gidTable->hasTile(gid));
+			CHECK((*map.gidTable)[gid].texture == nullptr);
+		}
+
+		CHECK(&map.tilesets[0].getTexture() != &map.tilesets[1].getTexture());
+		CHECK(&map.tilesets[1].getTexture() != &map.tilesets[2].getTexture());
+	}
+
+	// The layer keeps the gids as saved, the flip bits of the last one split off.
+	CHECK_EQ(map.layers.size(), std::size_t(1));
+
+	if (!map.layers.empty()) {
+		const tmx::Layer &layer = map.layers[0];
+
+		for (std::size_t i = 0; i < gids.size(); i++) {
+			CHECK_EQ(layer.data[i], static_cast<int>(gids[i] & ~tmx::GID_FLAGS));
+		}
+	}
+
+	fixture::removeBase(base);
+
+	return check::result();
+}
@@ -0,0 +1,176 @@
+#include "fixtures.hpp"
+
+#include "tmx-parser/map.hpp"
+
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <tinyxml2.h>
+#include <vector>
+
+namespace
+{
+const unsigned int MAP_SIZE = 1024;
+const int RUNS = 5;
+
+// Milliseconds per load of the map, its cache removed first so every load parses the xml.
+double measureColdLoad(const std::string &base, const std::string &filename)
+{
+	std::string cachePath = base + "/" + filename + ".cache";
+	double total = 0.0;
+
+	for (int run = 0; run < RUNS; run++) {
+		boost::filesystem::remove(cachePath);
+
+		auto start = std::chrono::steady_clock::now();
+		tmx::Map map(base, filename, false);
+		std::chrono::duration<double, std::milli> elapsed =
+		    std::chrono::steady_clock::now() - start;
+
+		total += elapsed.count();
+	}
+
+	return total / RUNS;
+}
+
+// Milliseconds per load of the map from the cache its last cold load wrote.
+double measureCachedLoad(const std::string &base, const std::string &filename)
+{
+	double total = 0.0;
+
+	for (int run = 0; run < RUNS; run++) {
+		auto start = std::chrono::steady_clock::now();
+		tmx::Map map(base, filename, false);
+		std::chrono::duration<double, std::milli> elapsed =
+		    std::chrono::steady_clock::now() - start;
+
+		total += elapsed.count();
+	}
+
+	return total / RUNS;
+}
+
+// The csv parsing the layers did before the one pass parser, kept as the baseline.
+std::vector<int> parseCsvCopy(const char *text)
+{
+	std::vector<int> gids;
+	std::string dataText = text;
+	std::replace(dataText.begin(), dataText.end(), ',', ' ');
+
+	std::stringstream ss(dataText);
+	std::copy(std::istream_iterator<int>(ss), std::istream_iterator<int>(),
+		  std::back_inserter(gids));
+
+	return gids;
+}
+
+// Megabytes of layer text parsed per second by parse, the best of the runs.
+template <typename Parse> double measureThroughput(std::size_t textSize, Parse parse)
+{
+	double best = 0.0;
+
+	for (int run = 0; run < RUNS; run++) {
+		auto start = std::chrono::steady_clock::now();
+		parse();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		best = std::max(best, static_cast<double>(textSize) / 1e6 / elapsed.count());
+	}
+
+	return best;
+}
+} // namespace
+
+int main()
+{
+	std::string base = fixture::makeBase();
+	fixture::writeTileset(base, "terrain", 16, 16, 16);
+
+	// A full ground layer, scattered detail and a mostly empty overlay, like a real map.
+	std::size_t cells = static_cast<std::size_t>(MAP_SIZE) * MAP_SIZE;
+	std::vector<unsigned int> ground(cells);
+	std::vector<unsigned int> detail(cells, 0);
+	std::vector<unsigned int> overlay(cells, 0);
+
+	for (std::size_t i = 0; i < cells; i++) {
+		ground[i] = 1 + static_cast<unsigned int>(i * 7919 % 256);
+
+		if (i % 5 == 0) {
+			detail[i] = 1 + static_cast<unsigned int>(i % 64);
+		}
+
+		if (i % 31 == 0) {
+			overlay[i] = 200 + static_cast<unsigned int>(i % 56);
+		}
+	}
+
+	std::vector<fixture::LayerSpec> layers{
+	    {"ground", ground}, {"detail", detail}, {"overlay", overlay, false, true}};
+
+	struct Format {
+		const char *name;
+		fixture::Encoding encoding;
+	};
+
+	// clang-format off
+	const Format formats[] = {
+		{"csv", fixture::Encoding::CSV},
+		{"base64", fixture::Encoding::BASE64},
+		{"base64 zlib", fixture::Encoding::ZLIB},
+		{"base64 gzip", fixture::Encoding::GZIP},
+	};
+	// clang-format on
+
+	std::printf("%-12s %10s %12s %12s\n", "encoding", "file MB", "cold ms", "cached ms");
+
+	for (const Format &format : formats) {
+		std::string filename = fixture::writeMap(base, format.name, MAP_SIZE, MAP_SIZE, 16,
+							 {{"terrain", 1}}, layers, format.encoding);
+		double megabytes =
+		    static_cast<double>(boost::filesystem::file_size(base + "/" + filename)) / 1e6;
+
+		double coldMs = measureColdLoad(base, filename);
+		double cachedMs = measureCachedLoad(base, filename);
+
+		std::printf("%-12s %10.2f %12.2f %12.2f\n", format.name, megabytes, coldMs,
+			    cachedMs);
+	}
+
+	// The csv of the ground layer alone, through tmx::Layer and through the old parser.
+	std::string layerXml = "<layer id=\"1\" name=\"ground\" width=\"" +
+			       std::to_string(MAP_SIZE) + "\" height=\"" +
+			       std::to_string(MAP_SIZE) + "\">" +
+			       fixture::dataElement(ground, MAP_SIZE, fixture::Encoding::CSV) +
+			       "</layer>";
+
+	tinyxml2::XMLDocument document;
+	document.Parse(layerXml.c_str(), layerXml.size());
+
+	tinyxml2::XMLElement *layerElement = document.RootElement();
+	const char *csv = layerElement->FirstChildElement("data")->GetText();
+	std::size_t csvSize = std::strlen(csv);
+
+	std::size_t layerTiles = 0;
+	std::size_t copyTiles = 0;
+
+	double layerRate = measureThroughput(csvSize, [&]() {
+		tmx::Layer layer(layerElement);
+		layerTiles = layer.data.size();
+	});
+	double copyRate = measureThroughput(csvSize, [&]() {
+		copyTiles = parseCsvCopy(csv).size();
+	});
+
+	std::printf("\n%-12s %10s %12s %12s\n", "csv parser", "text MB", "MB/s", "tiles");
+	std::printf("%-12s %10.2f %12.1f %12zu\n", "one pass", csvSize / 1e6, layerRate,
+		    layerTiles);
+	std::printf("%-12s %10.2f %12.1f %12zu\n", "copy", csvSize / 1e6, copyRate, copyTiles);
+
+	fixture::removeBase(base);
+
+	return 0;
+}
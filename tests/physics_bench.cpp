@@ -0,0 +1,117 @@
+#include "physics_scene.hpp"
+
+#include "physics/broadphase.hpp"
+#include "systems/rigid_physics_system.hpp"
+
+#include <cstdio>
+#include <unordered_map>
+
+namespace
+{
+// The pair loop the spatial hash replaced, every query looks at every proxy.
+class BruteForceBroadphase : public physics::Broadphase
+{
+public:
+	void insert(std::uint32_t id, const physics::AABB &box,
+		    const CollisionFilter &filter) override
+	{
+		mIndex[id] = mProxies.size();
+		mProxies.push_back(Proxy{id, box, filter});
+	}
+
+	void update(std::uint32_t id, const physics::AABB &box,
+		    const CollisionFilter &filter) override
+	{
+		mProxies[mIndex[id]] = Proxy{id, box, filter};
+	}
+
+	void remove(std::uint32_t id) override
+	{
+		std::size_t index = mIndex[id];
+
+		mProxies[index] = mProxies.back();
+		mIndex[mProxies[index].id] = index;
+		mProxies.pop_back();
+		mIndex.erase(id);
+	}
+
+	bool contains(std::uint32_t id) const override
+	{
+		return mIndex.count(id) != 0;
+	}
+
+	void query(const physics::AABB &box, const CollisionFilter &filter,
+		   std::vector<std::uint32_t> &results) const override
+	{
+		for (const Proxy &proxy : mProxies) {
+			if (physics::AABBvsAABB(box, proxy.box) &&
+			    shouldCollide(filter, proxy.filter)) {
+				results.push_back(proxy.id);
+			}
+		}
+	}
+
+private:
+	struct Proxy {
+		std::uint32_t id;
+		physics::AABB box;
+		CollisionFilter filter;
+	};
+
+	std::vector<Proxy> mProxies;
+	std::unordered_map<std::uint32_t, std::size_t> mIndex;
+};
+} // namespace
+
+int main()
+{
+	// Broadphase scaling: the spatial hash from 100 to 100k bodies, brute force up to 10k.
+	std::printf("%10s %16s %16s\n", "bodies", "hash ms/tick", "brute ms/tick");
+
+	for (std::size_t bodies : {100, 1000, 10000, 50000, 100000}) {
+		unsigned int ticks = bodies > 10000 ? 20 : 60;
+
+		PhysicsScene<RigidPhysicsSystem> hashed(bodies);
+		double hashMs = hashed.measure(ticks);
+
+		if (bodies > 10000) {
+			std::printf("%10zu %16.3f %16s\n", bodies, hashMs, "-");
+			continue;
+		}
+
+		PhysicsScene<RigidPhysicsSystem> brute(bodies);
+		brute.system().setBroadphase(std::make_unique<BruteForceBroadphase>());
+		double bruteMs = brute.measure(bodies > 1000 ? 5 : ticks, 2);
+
+		std::printf("%10zu %16.3f %16.3f\n", bodies, hashMs, bruteMs);
+	}
+
+	// Islands solved on 1 to 8 threads at 50k bodies, the positions have to come out the
+	// same whatever the thread count.
+	std::printf("\n%10s %16s %18s\n", "threads", "50k ms/tick", "position hash");
+
+	std::uint64_t serialHash = 0;
+	bool deterministic = true;
+
+	for (unsigned int threads : {1u, 2u, 4u, 8u}) {
+		PhysicsScene<RigidPhysicsSystem> scene(50000);
+		scene.system().setThreadCount(threads);
+		double ms = scene.measure(20);
+		std::uint64_t hash = scene.positionHash();
+
+		if (threads == 1) {
+			serialHash = hash;
+		}
+		deterministic = deterministic && hash == serialHash;
+
+		std::printf("%10u %16.3f %18llx\n", threads, ms,
+			    static_cast<unsigned long long>(hash));
+	}
+
+	if (!deterministic) {
+		std::printf("Thread counts disagree on the result.\n");
+		return 1;
+	}
+
+	return 0;
+}
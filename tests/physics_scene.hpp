@@ -0,0 +1,178 @@
+#ifndef TESTS_PHYSICS_SCENE_HPP
+#define TESTS_PHYSICS_SCENE_HPP
+
+#include <SFML/System.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "ecs.hpp"
+#include "physics/aabb.hpp"
+#include "tmx-parser/map.hpp"
+
+#include "components/collision_filter.hpp"
+#include "components/renderable.hpp"
+#include "components/rigidbody.hpp"
+#include "components/transform.hpp"
+
+/* The scene every physics benchmark runs: 8x8 bodies packed into piles of 256 on an empty map.
+ * Each tick every body is pushed towards the middle of its pile, moved by its velocity the way
+ * PlayerSystem moves the player, and then handed to the physics system. The piles stay dense
+ * and nearly every body touches another, so nothing gets to sleep. */
+template <typename System> class PhysicsScene
+{
+public:
+	static const unsigned int PILE_BODIES = 256;
+
+	explicit PhysicsScene(std::size_t bodies, unsigned int seed = 1)
+	{
+		mCoordinator = std::make_unique<ecs::Coordinator>();
+		mCoordinator->init();
+
+		mCoordinator->registerComponent<Transform>();
+		mCoordinator->registerComponent<Renderable>();
+		mCoordinator->registerComponent<RigidBody>();
+		mCoordinator->registerComponent<CollisionFilter>();
+
+		mSystem = mCoordinator->registerSystem<System>();
+		{
+			ecs::Signature signature;
+			signature.set(mCoordinator->getComponentType<RigidBody>());
+			signature.set(mCoordinator->getComponentType<Transform>());
+			signature.set(mCoordinator->getComponentType<Renderable>());
+
+			mCoordinator->setSystemSignature<System>(signature);
+		}
+		mSystem->init(mCoordinator.get(), nullptr);
+
+		// Piles sit on a square grid with room to spare between them.
+		std::size_t piles = (bodies + PILE_BODIES - 1) / PILE_BODIES;
+		std::size_t pilesPerRow = static_cast<std::size_t>(std::ceil(std::sqrt(piles)));
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> jitter(-0.4f, 0.4f);
+
+		for (std::size_t i = 0; i < bodies; i++) {
+			std::size_t pile = i / PILE_BODIES;
+			std::size_t slot = i % PILE_BODIES;
+
+			float pileX = static_cast<float>(pile % pilesPerRow);
+			float pileY = static_cast<float>(pile / pilesPerRow);
+			float slotX = static_cast<float>(slot % 16) - 8.f;
+			float slotY = static_cast<float>(slot / 16) - 8.f;
+
+			sf::Vector2f center(pileX * 256.f + 128.f, pileY * 256.f + 128.f);
+			sf::Vector2f position(center.x + slotX * 9.f, center.y + slotY * 9.f);
+			position += sf::Vector2f(jitter(random), jitter(random));
+
+			ecs::Entity entity = mCoordinator->createEntity();
+			// clang-format off
+			mCoordinator->addComponent(entity, Transform{
+				.position = position,
+				.previousPosition = position,
+			});
+			mCoordinator->addComponent(entity, Renderable{
+				.color = sf::Color::White,
+				.size = sf::Vector2f(8.f, 8.f),
+			});
+			mCoordinator->addComponent(entity, RigidBody{
+				.velocity = sf::Vector2f(0.f, 0.f),
+				.acceleration = sf::Vector2f(0.f, 0.f),
+				.deceleration = sf::Vector2f(0.f, 0.f),
+			});
+			// clang-format on
+
+			mBodies.push_back(Body{entity, center});
+		}
+	}
+
+	void step(sf::Time deltaTime)
+	{
+		float seconds = deltaTime.asSeconds();
+
+		for (const Body &body : mBodies) {
+			auto &transform = mCoordinator->getComponent<Transform>(body.entity);
+			auto &rigidbody = mCoordinator->getComponent<RigidBody>(body.entity);
+
+			sf::Vector2f toCenter = body.center - transform.position;
+			float distance = physics::vecLength(toCenter);
+
+			// 60 pixels per second towards the middle, nothing once there.
+			rigidbody.velocity = sf::Vector2f(0.f, 0.f);
+			if (distance > 1.f) {
+				rigidbody.velocity = toCenter * (60.f / distance);
+			}
+
+			transform.position += rigidbody.velocity * seconds;
+		}
+
+		mSystem->update(&mMap, deltaTime);
+	}
+
+	// Milliseconds per tick averaged over ticks, after a few to let the piles settle in.
+	double measure(unsigned int ticks, unsigned int warmup = 10)
+	{
+		sf::Time tick = sf::seconds(1.f / 60.f);
+
+		for (unsigned int i = 0; i < warmup; i++) {
+			step(tick);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (unsigned int i = 0; i < ticks; i++) {
+			step(tick);
+		}
+
+		std::chrono::duration<double, std::milli> elapsed =
+		    std::chrono::steady_clock::now() - start;
+
+		return elapsed.count() / ticks;
+	}
+
+	// FNV-1a over every position's bits, equal only when the runs match bit for bit.
+	std::uint64_t positionHash()
+	{
+		std::uint64_t hash = 14695981039346656037ull;
+
+		for (const Body &body : mBodies) {
+			sf::Vector2f position =
+			    mCoordinator->getComponent<Transform>(body.entity).position;
+			std::uint32_t bits[2];
+			std::memcpy(bits, &position.x, sizeof(float));
+			std::memcpy(bits + 1, &position.y, sizeof(float));
+
+			for (std::uint32_t word : bits) {
+				hash = (hash ^ word) * 1099511628211ull;
+			}
+		}
+
+		return hash;
+	}
+
+	System &system()
+	{
+		return *mSystem;
+	}
+
+	ecs::Coordinator &coordinator()
+	{
+		return *mCoordinator;
+	}
+
+private:
+	struct Body {
+		ecs::Entity entity;
+		sf::Vector2f center;
+	};
+
+	std::unique_ptr<ecs::Coordinator> mCoordinator;
+	std::shared_ptr<System> mSystem;
+	std::vector<Body> mBodies;
+	tmx::Map mMap;
+};
+
+#endif
@@ -0,0 +1,395 @@
+#include "check.hpp"
+#include "fixtures.hpp"
+
+#include "physics/queries.hpp"
+#include "physics/spatial_hash_grid.hpp"
+#include "tmx-parser/map.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+using physics::STATIC_BODY;
+
+const unsigned int SIZE = 32; // Tiles per side.
+const float TILE = 16.f;
+const float STEP = 1.f / 16.f; // How finely the brute force marches along a ray.
+const float INF = std::numeric_limits<float>::infinity();
+
+// A blocking layer with walls below row 4 and one tile at 20, 2, and bodies kept in a grid.
+struct World {
+	std::vector<unsigned int> walls;
+	std::vector<physics::AABB> boxes;
+	std::vector<CollisionFilter> filters;
+	physics::SpatialHashGrid grid{32.f};
+
+	std::uint32_t add(physics::AABB box, std::uint32_t category = 1)
+	{
+		std::uint32_t id = static_cast<std::uint32_t>(boxes.size());
+		CollisionFilter filter{.category = category};
+
+		boxes.push_back(box);
+		filters.push_back(filter);
+		grid.insert(id, box, filter);
+
+		return id;
+	}
+
+	bool isWall(int col, int row) const
+	{
+		return col >= 0 && row >= 0 && col < static_cast<int>(SIZE) &&
+		       row < static_cast<int>(SIZE) && walls[row * SIZE + col] != 0;
+	}
+
+	physics::AABB tileBox(int col, int row) const
+	{
+		sf::Vector2f min(col * TILE, row * TILE);
+		return physics::AABB{.min = min, .max = min + sf::Vector2f(TILE, TILE)};
+	}
+};
+
+physics::AABB makeBox(float left, float top, float right, float bottom)
+{
+	return physics::AABB{.min = sf::Vector2f(left, top), .max = sf::Vector2f(right, bottom)};
+}
+
+bool strictlyInside(sf::Vector2f point, const physics::AABB &box)
+{
+	const float margin = 1e-3f;
+	return point.x > box.min.x + margin && point.x < box.max.x - margin &&
+	       point.y > box.min.y + margin && point.y < box.max.y - margin;
+}
+
+bool nearBox(sf::Vector2f point, const physics::AABB &box)
+{
+	const float margin = 0.02f;
+	return point.x >= box.min.x - margin && point.x <= box.max.x + margin &&
+	       point.y >= box.min.y - margin && point.y <= box.max.y + margin;
+}
+
+// True if the point is inside something the ray can hit.
+bool blocksRay(const World &world, const physics::Ray &ray, sf::Vector2f point)
+{
+	if ((ray.filter.mask & 1u) != 0) {
+		int col = static_cast<int>(std::floor(point.x / TILE));
+		int row = static_cast<int>(std::floor(point.y / TILE));
+
+		if (world.isWall(col, row) && strictlyInside(point, world.tileBox(col, row))) {
+			return true;
+		}
+	}
+
+	for (std::uint32_t id = 0; id < world.boxes.size(); id++) {
+		if (id != ray.ignore && shouldCollide(ray.filter, world.filters[id]) &&
+		    strictlyInside(point, world.boxes[id])) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// How far an endless ray is followed: until it leaves the map, or the box from the map to the
+// origin when it starts outside.
+float endlessReach(sf::Vector2f origin, sf::Vector2f direction)
+{
+	float mapSize = SIZE * TILE;
+	float reach = INF;
+
+	for (int axis = 0; axis < 2; axis++) {
+		float start = axis == 0 ? origin.x : origin.y;
+		float step = axis == 0 ? direction.x : direction.y;
+
+		if (step > 0.f) {
+			reach = std::min(reach, (std::max(start, mapSize) - start) / step);
+		} else if (step < 0.f) {
+			reach = std::min(reach, (std::min(start, 0.f) - start) / step);
+		}
+	}
+
+	return reach;
+}
+
+// Checks a raycast against a march along the ray: nothing it can hit lies before the
+// reported hit, the hit is on the reported tile or body, and the normal faces the ray.
+void checkRay(const World &world, const tmx::Map &map, const physics::Ray &ray)
+{
+	auto getBox = [&world](std::uint32_t id) { return world.boxes[id]; };
+
+	physics::RayHit hit;
+	bool found = physics::raycast(world.grid, getBox, map, ray, hit);
+	CHECK_EQ(found, hit.hit);
+
+	sf::Vector2f direction = ray.direction / physics::vecLength(ray.direction);
+	float reach = std::isfinite(ray.maxDistance) ? ray.maxDistance
+						     : endlessReach(ray.origin, direction);
+	float clear = hit.hit ? hit.distance : reach;
+
+	for (float t = 0.f; t < clear - STEP; t += STEP) {
+		if (blocksRay(world, ray, ray.origin + direction * t)) {
+			CHECK(!"the ray passed something it should have hit");
+			return;
+		}
+	}
+
+	if (!hit.hit) {
+		return;
+	}
+
+	sf::Vector2f point = ray.origin + direction * hit.distance;
+	CHECK(physics::vecLength(hit.point - point) < 1e-3f);
+
+	// Just past the hit point is inside what was hit.
+	sf::Vector2f probe = hit.distance > 0.f ? point + direction * 0.01f : ray.origin;
+	physics::AABB box;
+
+	if (hit.body == STATIC_BODY) {
+		int col = static_cast<int>(std::floor(probe.x / TILE));
+		int row = static_cast<int>(std::floor(probe.y / TILE));
+
+		CHECK((ray.filter.mask & 1u) != 0);
+		CHECK(world.isWall(col, row));
+		box = world.tileBox(col, row);
+	} else {
+		CHECK(hit.body < world.boxes.size());
+
+		if (hit.body >= world.boxes.size()) {
+			return;
+		}
+
+		CHECK(hit.body != ray.ignore);
+		CHECK(shouldCollide(ray.filter, world.filters[hit.body]));
+		box = world.boxes[hit.body];
+	}
+
+	CHECK(nearBox(probe, box));
+
+	if (hit.distance == 0.f) {
+		CHECK(hit.normal == sf::Vector2f(0.f, 0.f));
+		return;
+	}
+
+	// An axis normal against the ray, on the face of the box the ray came through.
+	CHECK(std::abs(hit.normal.x) + std::abs(hit.normal.y) == 1.f);
+	CHECK(physics::vecDot(hit.normal, direction) < 0.f);
+
+	if (hit.normal.x != 0.f) {
+		float face = hit.normal.x < 0.f ? box.min.x : box.max.x;
+		CHECK(std::abs(point.x - face) < 0.01f);
+	} else {
+		float face = hit.normal.y < 0.f ? box.min.y : box.max.y;
+		CHECK(std::abs(point.y - face) < 0.01f);
+	}
+}
+
+// What a ray should hit, and where.
+void checkHit(const World &world, const tmx::Map &map, const physics::Ray &ray,
+	      std::uint32_t body, float distance, sf::Vector2f normal)
+{
+	auto getBox = [&world](std::uint32_t id) { return world.boxes[id]; };
+
+	physics::RayHit hit;
+	CHECK(physics::raycast(world.grid, getBox, map, ray, hit));
+	CHECK_EQ(hit.body, body);
+	CHECK(std::abs(hit.distance - distance) < 1e-3f);
+	CHECK(hit.normal == normal);
+}
+
+void checkMiss(const World &world, const tmx::Map &map, const physics::Ray &ray)
+{
+	auto getBox = [&world](std::uint32_t id) { return world.boxes[id]; };
+
+	physics::RayHit hit;
+	CHECK(!physics::raycast(world.grid, getBox, map, ray, hit));
+	CHECK(!hit.hit);
+}
+
+// Both touch or overlap, and the circle's closest point to a box is inside it.
+bool touches(const physics::AABB &a, const physics::AABB &b)
+{
+	return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y &&
+	       a.max.y >= b.min.y;
+}
+
+bool touches(sf::Vector2f center, float radius, const physics::AABB &box)
+{
+	float dx = std::max({box.min.x - center.x, 0.f, center.x - box.max.x});
+	float dy = std::max({box.min.y - center.y, 0.f, center.y - box.max.y});
+	return dx * dx + dy * dy <= radius * radius;
+}
+
+// Every body the filter accepts that overlaps, sorted, then STATIC_BODY if a wall
+// does.
+template <typename Overlaps>
+std::vector<std::uint32_t> bruteForce(const World &world, const CollisionFilter &filter,
+				      Overlaps overlaps)
+{
+	std::vector<std::uint32_t> hits;
+
+	for (std::uint32_t id = 0; id < world.boxes.size(); id++) {
+		if (shouldCollide(filter, world.filters[id]) && overlaps(world.boxes[id])) {
+			hits.push_back(id);
+		}
+	}
+
+	if ((filter.mask & 1u) == 0) {
+		return hits;
+	}
+
+	for (int row = 0; row < static_cast<int>(SIZE); row++) {
+		for (int col = 0; col < static_cast<int>(SIZE); col++) {
+			if (world.isWall(col, row) && overlaps(world.tileBox(col, row))) {
+				hits.push_back(STATIC_BODY);
+				return hits;
+			}
+		}
+	}
+
+	return hits;
+}
+
+// Region queries against every body and wall tile.
+void checkRegions(const World &world, const tmx::Map &map, std::mt19937 &random)
+{
+	auto getBox = [&world](std::uint32_t id) { return world.boxes[id]; };
+
+	std::uniform_real_distribution<float> position(-32.f, SIZE * TILE + 32.f);
+	std::uniform_real_distribution<float> extent(0.5f, 40.f);
+	const std::uint32_t masks[] = {~0u, ~1u, ~2u, 1u};
+
+	std::vector<std::uint32_t> found;
+
+	for (unsigned int i = 0; i < 300; i++) {
+		CollisionFilter filter{.mask = masks[i % 4]};
+
+		sf::Vector2f min(position(random), position(random));
+		physics::AABB region{.min = min,
+				     .max = min + sf::Vector2f(extent(random), extent(random))};
+
+		auto inRegion = [&region](const physics::AABB &box) {
+			return touches(region, box);
+		};
+		physics::queryAABB(world.grid, getBox, map, region, filter, found);
+		CHECK(found == bruteForce(world, filter, inRegion));
+
+		sf::Vector2f center(position(random), position(random));
+		float radius = extent(random);
+
+		auto inCircle = [center, radius](const physics::AABB &box) {
+			return touches(center, radius, box);
+		};
+		physics::queryCircle(world.grid, getBox, map, center, radius, filter, found);
+		CHECK(found == bruteForce(world, filter, inCircle));
+	}
+}
+} // namespace
+
+// Raycasts and region queries over bodies and tiles, checked against brute force.
+int main()
+{
+	std::mt19937 random(11);
+
+	World world;
+	world.walls.assign(SIZE * SIZE, 0);
+
+	std::uniform_int_distribution<int> percent(0, 99);
+	for (unsigned int i = 4 * SIZE; i < SIZE * SIZE; i++) {
+		world.walls[i] = percent(random) < 10 ? 1 : 0;
+	}
+	world.walls[2 * SIZE + 20] = 1;
+
+	std::string base = fixture::makeBase();
+	fixture::writeTileset(base, "walls", 4, 4, 16);
+
+	fixture::LayerSpec layer{"walls", world.walls, true};
+	std::string filename = fixture::writeMap(base, "queries", SIZE, SIZE, 16,
+						 {{"walls", 1}}, {layer});
+	tmx::Map map(base, filename, false);
+
+	// The rows above 4 are clear apart from these, for rays with a known answer.
+	std::uint32_t far = world.add(makeBox(400.f, 20.f, 410.f, 28.f));
+	std::uint32_t outside = world.add(makeBox(-60.f, 20.f, -50.f, 28.f));
+	std::uint32_t first = world.add(makeBox(200.f, 52.f, 210.f, 60.f));
+	world.add(makeBox(200.f, 52.f, 210.f, 60.f));
+	std::uint32_t atWall = world.add(makeBox(320.f, 36.f, 330.f, 44.f), 2);
+	std::uint32_t other = world.add(makeBox(100.f, 52.f, 110.f, 60.f), 2);
+
+	std::uniform_real_distribution<float> place(0.f, SIZE * TILE - 24.f);
+	std::uniform_real_distribution<float> size(3.f, 20.f);
+
+	for (unsigned int i = 0; i < 60; i++) {
+		sf::Vector2f min(place(random), 64.f + place(random) * 0.85f);
+		world.add(physics::AABB{.min = min, .max = min + sf::Vector2f(size(random),
+									      size(random))},
+			  1u << (i % 2));
+	}
+
+	const sf::Vector2f right(1.f, 0.f);
+	const sf::Vector2f left(-1.f, 0.f);
+	const sf::Vector2f none(0.f, 0.f);
+
+	// Endless rays past the tiles still find bodies, also from outside the map.
+	checkHit(world, map, physics::Ray{sf::Vector2f(8.f, 24.f), right, INF}, far, 392.f, left);
+	checkHit(world, map, physics::Ray{sf::Vector2f(-100.f, 24.f), right, INF}, outside, 40.f,
+		 left);
+	checkHit(world, map,
+		 physics::Ray{sf::Vector2f(-100.f, 24.f), right, INF, CollisionFilter{}, outside},
+		 far, 500.f, left);
+	checkMiss(world, map, physics::Ray{sf::Vector2f(8.f, 24.f), right, 100.f});
+	checkMiss(world, map, physics::Ray{sf::Vector2f(8.f, 24.f), left, INF});
+
+	// Filters, and ties going to the lower id, then to tiles.
+	checkHit(world, map, physics::Ray{sf::Vector2f(8.f, 56.f), right, INF}, other, 92.f,
+		 left);
+	checkHit(world, map,
+		 physics::Ray{sf::Vector2f(8.f, 56.f), right, INF, CollisionFilter{.mask = ~2u}},
+		 first, 192.f, left);
+	checkHit(world, map, physics::Ray{sf::Vector2f(300.f, 40.f), right, INF}, STATIC_BODY,
+		 20.f, left);
+	checkHit(world, map,
+		 physics::Ray{sf::Vector2f(300.f, 40.f), right, INF, CollisionFilter{.mask = ~1u}},
+		 atWall, 20.f, left);
+
+	// Rays starting inside what they hit, unless it's the one they ignore.
+	checkHit(world, map, physics::Ray{sf::Vector2f(105.f, 56.f), right, INF}, other, 0.f,
+		 none);
+	checkHit(world, map,
+		 physics::Ray{sf::Vector2f(105.f, 56.f), right, INF, CollisionFilter{}, other},
+		 first, 95.f, left);
+	checkHit(world, map, physics::Ray{sf::Vector2f(328.f, 40.f), right, 10.f}, STATIC_BODY,
+		 0.f, none);
+
+	// Rays that can't hit anything.
+	checkMiss(world, map, physics::Ray{sf::Vector2f(8.f, 24.f), none, INF});
+	checkMiss(world, map, physics::Ray{sf::Vector2f(8.f, 24.f), right, -1.f});
+	checkMiss(world, map,
+		  physics::Ray{sf::Vector2f(8.f, 24.f), right, std::nanf("")});
+
+	// Random rays from inside and outside the map, some endless, some ignoring a body.
+	std::uniform_real_distribution<float> origin(-64.f, SIZE * TILE + 64.f);
+	std::uniform_real_distribution<float> angle(0.f, 6.2831853f);
+	std::uniform_real_distribution<float> distance(0.f, 600.f);
+	std::uniform_int_distribution<std::uint32_t> body(0, world.boxes.size() - 1);
+	const std::uint32_t masks[] = {~0u, ~1u, ~2u, 1u};
+
+	for (unsigned int i = 0; i < 400; i++) {
+		float a = angle(random);
+		physics::Ray ray{sf::Vector2f(origin(random), origin(random)),
+				 sf::Vector2f(std::cos(a), std::sin(a)),
+				 i % 3 == 0 ? INF : distance(random)};
+		ray.filter.mask = masks[i % 4];
+		ray.ignore = i % 4 == 1 ? body(random) : STATIC_BODY;
+
+		checkRay(world, map, ray);
+	}
+
+	checkRegions(world, map, random);
+
+	fixture::removeBase(base);
+
+	return check::result();
+}
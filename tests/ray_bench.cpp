@@ -0,0 +1,132 @@
+#include "fixtures.hpp"
+
+#include "physics/queries.hpp"
+#include "physics/spatial_hash_grid.hpp"
+#include "tmx-parser/map.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+const unsigned int MAP_SIZE = 256;
+const unsigned int TILE = 16;
+const std::size_t BODIES = 10000;
+const std::size_t RAYS = 200000;
+const int RUNS = 5;
+
+// Rays cast per second through the batched raycast, the best of the runs.
+template <typename GetBox>
+double measureRays(const physics::SpatialHashGrid &grid, GetBox &&getBox, const tmx::Map &map,
+		   const std::vector<physics::Ray> &rays, std::size_t &hitCount)
+{
+	std::vector<physics::RayHit> hits;
+	double best = 0.0;
+
+	for (int run = 0; run < RUNS; run++) {
+		auto start = std::chrono::steady_clock::now();
+		physics::raycast(grid, getBox, map, rays, hits);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		best = std::max(best, static_cast<double>(rays.size()) / elapsed.count());
+	}
+
+	hitCount = 0;
+	for (const physics::RayHit &hit : hits) {
+		hitCount += hit.hit ? 1 : 0;
+	}
+
+	return best;
+}
+} // namespace
+
+int main()
+{
+	std::mt19937 random(7);
+	float mapSize = static_cast<float>(MAP_SIZE * TILE);
+
+	// A blocking layer with one tile in ten a wall.
+	std::vector<unsigned int> walls(MAP_SIZE * MAP_SIZE, 0);
+	std::uniform_int_distribution<int> percent(0, 99);
+
+	for (unsigned int &wall : walls) {
+		wall = percent(random) < 10 ? 1 : 0;
+	}
+
+	std::string base = fixture::makeBase();
+	fixture::writeTileset(base, "walls", 4, 4, 16);
+
+	fixture::LayerSpec layer{"walls", walls, true};
+	std::string filename =
+	    fixture::writeMap(base, "rays", MAP_SIZE, MAP_SIZE, TILE, {{"walls", 1}}, {layer});
+	tmx::Map map(base, filename, false);
+
+	// Bodies scattered over the map, the size of a player or smaller, in their own category.
+	std::vector<physics::AABB> boxes;
+	CollisionFilter bodyFilter{.category = 2};
+	physics::SpatialHashGrid grid;
+	std::uniform_real_distribution<float> place(0.f, mapSize - 32.f);
+	std::uniform_real_distribution<float> size(4.f, 32.f);
+
+	for (std::size_t i = 0; i < BODIES; i++) {
+		sf::Vector2f min(place(random), place(random));
+		sf::Vector2f extent(size(random), size(random));
+		physics::AABB box{.min = min, .max = min + extent};
+
+		grid.insert(static_cast<std::uint32_t>(i), box, bodyFilter);
+		boxes.push_back(box);
+	}
+
+	auto getBox = [&boxes](std::uint32_t id) { return boxes[id]; };
+
+	// Line of sight checks and rays with no end, against tiles and bodies or the tiles alone.
+	std::uniform_real_distribution<float> angle(0.f, 6.2831853f);
+	std::vector<physics::Ray> rays(RAYS);
+
+	for (physics::Ray &ray : rays) {
+		float a = angle(random);
+		ray.origin = sf::Vector2f(place(random), place(random));
+		ray.direction = sf::Vector2f(std::cos(a), std::sin(a));
+		ray.maxDistance = 512.f;
+	}
+
+	struct Case {
+		const char *name;
+		float maxDistance;
+		std::uint32_t mask;
+	};
+
+	const float inf = std::numeric_limits<float>::infinity();
+
+	// clang-format off
+	const Case cases[] = {
+		{"512 px", 512.f, ~0u},
+		{"endless", inf, ~0u},
+		{"512 px tiles", 512.f, 1u},
+		{"endless tiles", inf, 1u},
+	};
+	// clang-format on
+
+	std::printf("%-14s %14s %10s\n", "rays", "rays/s", "hits");
+
+	for (const Case &test : cases) {
+		for (physics::Ray &ray : rays) {
+			ray.maxDistance = test.maxDistance;
+			ray.filter.mask = test.mask;
+		}
+
+		std::size_t hitCount = 0;
+		double rate = measureRays(grid, getBox, map, rays, hitCount);
+
+		std::printf("%-14s %14.0f %10zu\n", test.name, rate, hitCount);
+	}
+
+	fixture::removeBase(base);
+
+	return 0;
+}
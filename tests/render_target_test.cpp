@@ -0,0 +1,54 @@
+#include "check.hpp"
+#include "fixtures.hpp"
+
+#include "render/target.hpp"
+#include "tmx-parser/map.hpp"
+
+#include <vector>
+
+// What drawing a map costs, counted by a RecordingTarget so no GPU is needed. The textures are
+// never loaded, the tilesets only need distinct ones to batch by.
+int main()
+{
+	std::string base = fixture::makeBase();
+	fixture::writeTileset(base, "grass", 4, 4, 16);
+	fixture::writeTileset(base, "rocks", 4, 4, 16);
+
+	// 32x32 tiles are 2x2 chunks. The ground is all grass, the detail layer has a row of
+	// rocks and a row of grass.
+	std::vector<unsigned int> ground(32 * 32, 1);
+	std::vector<unsigned int> detail(32 * 32, 0);
+	for (unsigned int x = 0; x < 32; x++) {
+		detail[x] = 17;
+		detail[32 + x] = 2;
+	}
+
+	std::string filename =
+	    fixture::writeMap(base, "cost", 32, 32, 16, {{"grass", 1}, {"rocks", 17}},
+			      {{"ground", ground}, {"detail", detail}});
+
+	tmx::Map map(base, filename, false);
+	render::RecordingTarget target;
+
+	// The whole map: one call for the ground, one per tileset for the detail layer.
+	map.drawRegion(target, sf::Rect<float>(0.f, 0.f, 512.f, 512.f));
+	CHECK_EQ(target.getStats().drawCalls, 3u);
+	CHECK_EQ(target.getStats().vertices, std::size_t((32 * 32 + 64) * 4));
+	CHECK(target.getStats().textureBinds <= 3u);
+	CHECK_EQ(target.getStats().fillArea, 512.0 * 512.0 + 64.0 * 16.0 * 16.0);
+
+	// Only the top left chunk is visible, the others aren't drawn at all.
+	target.reset();
+	map.drawRegion(target, sf::Rect<float>(0.f, 0.f, 100.f, 100.f));
+	CHECK_EQ(target.getStats().drawCalls, 3u);
+	CHECK_EQ(target.getStats().vertices, std::size_t((16 * 16 + 32) * 4));
+
+	// Nothing on screen, nothing drawn.
+	target.reset();
+	map.drawRegion(target, sf::Rect<float>(-200.f, -200.f, 100.f, 100.f));
+	CHECK_EQ(target.getStats().drawCalls, 0u);
+
+	fixture::removeBase(base);
+
+	return check::result();
+}
@@ -0,0 +1,109 @@
+#include "check.hpp"
+
+#include "render/snapshot.hpp"
+
+#include <vector>
+
+namespace
+{
+// Remembers every draw with the view it was drawn under.
+class LoggingTarget : public render::Target
+{
+public:
+	struct Draw {
+		std::size_t count;
+		const sf::Texture *texture;
+		const sf::Shader *shader;
+		sf::BlendMode blendMode;
+		sf::Vector2f viewCenter;
+	};
+
+	std::vector<Draw> draws;
+	unsigned int viewChanges = 0;
+
+	void draw(const sf::Vertex *, std::size_t count, sf::PrimitiveType,
+		  const sf::RenderStates &states = sf::RenderStates::Default) override
+	{
+		draws.push_back(Draw{count, states.texture, states.shader, states.blendMode,
+				     mView.getCenter()});
+	}
+
+	void setView(const sf::View &view) override
+	{
+		mView = view;
+		viewChanges++;
+	}
+
+private:
+	sf::View mView;
+};
+} // namespace
+
+// A frame replays with the states and views it was drawn with, only identical draws merge.
+int main()
+{
+	sf::Texture tiles;
+	sf::Shader tint;
+	sf::View world(sf::Vector2f(500.f, 500.f), sf::Vector2f(640.f, 480.f));
+	sf::View hud(sf::Vector2f(320.f, 240.f), sf::Vector2f(640.f, 480.f));
+
+	std::vector<sf::Vertex> quad(4);
+	sf::RenderStates plain(&tiles);
+	sf::RenderStates added(&tiles);
+	added.blendMode = sf::BlendAdd;
+	sf::RenderStates shaded(&tiles);
+	shaded.shader = &tint;
+
+	render::Snapshot frame;
+	frame.setView(world);
+	frame.draw(quad.data(), quad.size(), sf::Quads, plain);
+	frame.draw(quad.data(), quad.size(), sf::Quads, plain);
+	frame.draw(quad.data(), quad.size(), sf::Quads, added);
+	frame.draw(quad.data(), quad.size(), sf::Quads, shaded);
+	frame.draw(quad.data(), quad.size(), sf::Quads, plain);
+	frame.setView(hud);
+	frame.draw(quad.data(), quad.size(), sf::Quads, plain);
+
+	CHECK_EQ(frame.getBatchCount(), std::size_t(5));
+	CHECK_EQ(frame.getVertexCount(), std::size_t(24));
+
+	LoggingTarget target;
+	frame.replay(target);
+
+	CHECK_EQ(target.viewChanges, 2u);
+	CHECK_EQ(target.draws.size(), std::size_t(5));
+
+	if (target.draws.size() == 5) {
+		CHECK_EQ(target.draws[0].count, std::size_t(8));
+		CHECK(target.draws[0].blendMode == sf::BlendAlpha);
+		CHECK(target.draws[0].shader == nullptr);
+		CHECK(target.draws[1].blendMode == sf::BlendAdd);
+		CHECK(target.draws[2].shader == &tint);
+
+		for (std::size_t i = 0; i < 4; i++) {
+			CHECK(target.draws[i].texture == &tiles);
+			CHECK(target.draws[i].viewCenter == world.getCenter());
+		}
+
+		CHECK(target.draws[4].texture == &tiles);
+		CHECK(target.draws[4].viewCenter == hud.getCenter());
+	}
+
+	// Draws before any view was set leave the target's view alone, a trailing view is kept.
+	render::Snapshot unviewed;
+	unviewed.draw(quad.data(), quad.size(), sf::Quads, plain);
+	unviewed.setView(hud);
+
+	LoggingTarget second;
+	second.setView(world);
+	unviewed.replay(second);
+
+	CHECK_EQ(second.viewChanges, 2u);
+	CHECK_EQ(second.draws.size(), std::size_t(1));
+
+	if (!second.draws.empty()) {
+		CHECK(second.draws[0].viewCenter == world.getCenter());
+	}
+
+	return check::result();
+}
@@ -0,0 +1,189 @@
+#include "check.hpp"
+#include "fixtures.hpp"
+
+#include "ecs.hpp"
+#include "physics/aabb.hpp"
+#include "physics/aabb_batch.hpp"
+#include "systems/rigid_physics_system.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+physics::AABB box(float x, float y, float width, float height)
+{
+	return physics::AABB{.min = sf::Vector2f(x, y), .max = sf::Vector2f(x + width, y + height)};
+}
+
+// Time of impact and normal of a swept box, and the moves that mustn't count as hits.
+void checkSweptAABB()
+{
+	float toi = -1.f;
+	sf::Vector2f normal;
+
+	// 40 pixels of gap on a 100 pixel move.
+	CHECK(physics::sweptAABB(box(0.f, 0.f, 10.f, 10.f), sf::Vector2f(100.f, 0.f),
+				 box(50.f, -20.f, 10.f, 50.f), toi, normal));
+	CHECK(std::abs(toi - 0.4f) < 1e-6f);
+	CHECK(normal == sf::Vector2f(-1.f, 0.f));
+
+	// Diagonally onto a floor, y enters last so the floor is what is hit.
+	CHECK(physics::sweptAABB(box(0.f, 0.f, 10.f, 10.f), sf::Vector2f(20.f, 40.f),
+				 box(-100.f, 30.f, 300.f, 10.f), toi, normal));
+	CHECK(std::abs(toi - 0.5f) < 1e-6f);
+	CHECK(normal == sf::Vector2f(0.f, -1.f));
+
+	// Too short, sliding past, moving away and starting inside are all misses.
+	CHECK(!physics::sweptAABB(box(0.f, 0.f, 10.f, 10.f), sf::Vector2f(30.f, 0.f),
+				  box(50.f, 0.f, 10.f, 10.f), toi, normal));
+	CHECK(!physics::sweptAABB(box(0.f, 0.f, 10.f, 10.f), sf::Vector2f(100.f, 0.f),
+				  box(50.f, 10.f, 10.f, 10.f), toi, normal));
+	CHECK(!physics::sweptAABB(box(0.f, 0.f, 10.f, 10.f), sf::Vector2f(-100.f, 0.f),
+				  box(50.f, 0.f, 10.f, 10.f), toi, normal));
+	CHECK(!physics::sweptAABB(box(0.f, 0.f, 10.f, 10.f), sf::Vector2f(100.f, 0.f),
+				  box(5.f, 0.f, 10.f, 10.f), toi, normal));
+}
+
+// Every kernel the CPU has finds the same boxes as the scalar one, tails included.
+void checkKernels()
+{
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> position(0.f, 500.f);
+	std::uniform_real_distribution<float> size(1.f, 60.f);
+
+	physics::AABBBatch batch;
+	for (int i = 0; i < 1003; i++) {
+		batch.push(box(position(random), position(random), size(random), size(random)));
+	}
+
+	std::vector<physics::OverlapKernel> kernels{physics::overlapKernel()};
+#ifdef PHYSICS_AABB_BATCH_X86
+	kernels.push_back(physics::detail::overlapSSE2);
+	if (__builtin_cpu_supports("avx2")) {
+		kernels.push_back(physics::detail::overlapAVX2);
+	}
+#endif
+
+	std::vector<std::uint32_t> expected;
+	std::vector<std::uint32_t> hits;
+
+	for (int query = 0; query < 200; query++) {
+		physics::AABB target =
+		    box(position(random), position(random), size(random), size(random));
+		std::size_t first = static_cast<std::size_t>(query) % 11;
+		std::size_t count = batch.size() - first - static_cast<std::size_t>(query) % 7;
+
+		expected.clear();
+		physics::detail::overlapScalar(batch, first, count, target, expected);
+
+		for (physics::OverlapKernel kernel : kernels) {
+			hits.clear();
+			kernel(batch, first, count, target, hits);
+			CHECK(hits == expected);
+		}
+	}
+}
+
+// Bodies crossing more than their own size in a tick still stop at whatever is in the way,
+// another body or a one tile thick wall.
+void checkTunnelling()
+{
+	std::string base = fixture::makeBase();
+	fixture::writeTileset(base, "walls", 4, 4, 16);
+
+	// A wall one tile thick at x = 160.
+	std::vector<unsigned int> walls(32 * 16, 0);
+	for (unsigned int y = 0; y < 16; y++) {
+		walls[y * 32 + 10] = 1;
+	}
+
+	fixture::LayerSpec layer{"walls", walls};
+	layer.blocking = true;
+	tmx::Map map(base, fixture::writeMap(base, "wall", 32, 16, 16, {{"walls", 1}}, {layer}),
+		     false);
+
+	ecs::Coordinator coordinator;
+	coordinator.init();
+	coordinator.registerComponent<Transform>();
+	coordinator.registerComponent<Renderable>();
+	coordinator.registerComponent<RigidBody>();
+	coordinator.registerComponent<CollisionFilter>();
+
+	std::shared_ptr<RigidPhysicsSystem> physics =
+	    coordinator.registerSystem<RigidPhysicsSystem>();
+	{
+		ecs::Signature signature;
+		signature.set(coordinator.getComponentType<RigidBody>());
+		signature.set(coordinator.getComponentType<Transform>());
+		signature.set(coordinator.getComponentType<Renderable>());
+
+		coordinator.setSystemSignature<RigidPhysicsSystem>(signature);
+	}
+	physics->init(&coordinator, nullptr);
+
+	auto addBody = [&coordinator](sf::Vector2f position, sf::Vector2f size,
+				      sf::Vector2f velocity) {
+		ecs::Entity entity = coordinator.createEntity();
+
+		// clang-format off
+		coordinator.addComponent(entity, Transform{
+			.position = position,
+			.previousPosition = position,
+		});
+		coordinator.addComponent(entity, Renderable{
+			.color = sf::Color::White,
+			.size = size,
+		});
+		coordinator.addComponent(entity, RigidBody{
+			.velocity = velocity,
+			.acceleration = sf::Vector2f(0.f, 0.f),
+			.deceleration = sf::Vector2f(0.f, 0.f),
+		});
+		// clang-format on
+
+		return entity;
+	};
+
+	// 6000 pixels per second is 100 a tick, against a 2 pixel post and the 16 pixel wall.
+	ecs::Entity post = addBody(sf::Vector2f(60.f, 16.f), sf::Vector2f(2.f, 32.f),
+				   sf::Vector2f(0.f, 0.f));
+	ecs::Entity bullet = addBody(sf::Vector2f(0.f, 24.f), sf::Vector2f(8.f, 8.f),
+				     sf::Vector2f(6000.f, 0.f));
+	ecs::Entity wallBullet = addBody(sf::Vector2f(0.f, 120.f), sf::Vector2f(8.f, 8.f),
+					 sf::Vector2f(6000.f, 0.f));
+
+	sf::Time tick = sf::seconds(1.f / 60.f);
+
+	for (int i = 0; i < 10; i++) {
+		// Moved by velocity first, the way PlayerSystem moves the player.
+		for (ecs::Entity entity : {bullet, wallBullet}) {
+			auto &transform = coordinator.getComponent<Transform>(entity);
+			transform.position +=
+			    coordinator.getComponent<RigidBody>(entity).velocity * tick.asSeconds();
+		}
+
+		physics->update(&map, tick);
+	}
+
+	auto const &hit = coordinator.getComponent<Transform>(bullet);
+	auto const &walled = coordinator.getComponent<Transform>(wallBullet);
+
+	CHECK_EQ(hit.position.x, 60.f - 8.f);
+	CHECK_EQ(coordinator.getComponent<RigidBody>(bullet).velocity.x, 0.f);
+	CHECK_EQ(coordinator.getComponent<Transform>(post).position.x, 60.f);
+	CHECK_EQ(walled.position.x, 160.f - 8.f);
+
+	fixture::removeBase(base);
+}
+} // namespace
+
+int main()
+{
+	checkSweptAABB();
+	checkKernels();
+	checkTunnelling();
+
+	return check::result();
+}
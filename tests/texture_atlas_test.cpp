@@ -0,0 +1,78 @@
+#include "check.hpp"
+#include "fixtures.hpp"
+
+#include "render/target.hpp"
+#include "texture_atlas.hpp"
+#include "tmx-parser/map.hpp"
+
+#include <iostream>
+#include <vector>
+
+// Texture switches drawing a three tileset map with and without the atlas, and the atlas cache
+// going stale when an image changes. Packing uploads the pages, so this needs a display.
+int main()
+{
+	std::string base = fixture::makeBase();
+	fixture::writeTileset(base, "grass", 4, 4, 16, sf::Color::Green);
+	fixture::writeTileset(base, "rocks", 4, 4, 16, sf::Color(128, 128, 128));
+	fixture::writeTileset(base, "water", 4, 4, 16, sf::Color::Blue);
+
+	// Grass everywhere, a row of rocks and a row of water on top.
+	std::vector<unsigned int> ground(32 * 32, 1);
+	std::vector<unsigned int> detail(32 * 32, 0);
+	for (unsigned int x = 0; x < 32; x++) {
+		detail[x] = 17;
+		detail[32 + x] = 33;
+	}
+
+	std::string filename = fixture::writeMap(base, "atlas", 32, 32, 16,
+						 {{"grass", 1}, {"rocks", 17}, {"water", 33}},
+						 {{"ground", ground}, {"detail", detail}});
+
+	tmx::Map map(base, filename);
+	sf::Rect<float> view(0.f, 0.f, 512.f, 512.f);
+
+	render::RecordingTarget before;
+	map.drawRegion(before, view);
+
+	TextureAtlas atlas;
+	for (const tmx::Tileset &tileset : map.tilesets) {
+		CHECK(atlas.addImage(tileset.imagePath, tileset.imagePath));
+	}
+	CHECK(atlas.pack());
+	CHECK_EQ(atlas.getPageCount(), std::size_t(1));
+
+	map.useAtlas(atlas);
+
+	render::RecordingTarget after;
+	map.drawRegion(after, view);
+
+	std::cout << "Texture binds per frame: " << before.getStats().textureBinds
+		  << " without the atlas, " << after.getStats().textureBinds << " with it.\n"
+		  << "Draw calls per frame: " << before.getStats().drawCalls
+		  << " without the atlas, " << after.getStats().drawCalls << " with it.\n"
+		  << "Atlas occupancy: " << atlas.getOccupancy() * 100.f << "%\n";
+
+	CHECK_EQ(before.getStats().textureBinds, 3u);
+	CHECK_EQ(before.getStats().drawCalls, 3u);
+	CHECK_EQ(after.getStats().textureBinds, 1u);
+	CHECK_EQ(after.getStats().drawCalls, 2u);
+	CHECK_EQ(after.getStats().vertices, before.getStats().vertices);
+
+	// The cache loads while the images are untouched, a resized image invalidates it.
+	std::string cachePath = base + "/cache/atlas";
+	CHECK(atlas.saveToFile(cachePath));
+
+	TextureAtlas cached;
+	CHECK(cached.loadFromFile(cachePath));
+	CHECK(cached.find(map.tilesets[1].imagePath) != nullptr);
+
+	fixture::writeTileset(base, "rocks", 8, 4, 16);
+
+	TextureAtlas stale;
+	CHECK(!stale.loadFromFile(cachePath));
+
+	fixture::removeBase(base);
+
+	return check::result();
+}
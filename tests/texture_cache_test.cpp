@@ -0,0 +1,47 @@
+#include "check.hpp"
+#include "fixtures.hpp"
+
+#include "tmx-parser/map.hpp"
+#include "tmx-parser/texture-cache.hpp"
+
+#include <vector>
+
+// Two maps sharing a tileset upload its image once, and the cache forgets it once both are gone.
+int main()
+{
+	std::string base = fixture::makeBase();
+	fixture::writeTileset(base, "shared", 4, 4, 16);
+	fixture::writeTileset(base, "other", 4, 4, 16);
+
+	std::vector<unsigned int> gids(8 * 8, 1);
+	std::vector<fixture::LayerSpec> layers{{"ground", gids}, {"detail", gids}};
+	std::string first =
+	    fixture::writeMap(base, "first", 8, 8, 16, {{"shared", 1}}, layers);
+	std::string second =
+	    fixture::writeMap(base, "second", 8, 8, 16, {{"shared", 1}}, layers);
+	std::string third = fixture::writeMap(base, "third", 8, 8, 16, {{"other", 1}}, layers);
+
+	tmx::TextureCache &cache = tmx::TextureCache::shared();
+	unsigned int created = cache.getCreatedCount();
+
+	{
+		tmx::Map one(base, first);
+		tmx::Map two(base, second);
+
+		CHECK_EQ(cache.getCreatedCount() - created, 1u);
+		CHECK_EQ(cache.getEntryCount(), std::size_t(1));
+		CHECK(&one.tilesets[0].getTexture() == &two.tilesets[0].getTexture());
+	}
+
+	// Nothing holds the shared texture anymore, its entry goes with the next upload.
+	{
+		tmx::Map three(base, third);
+
+		CHECK_EQ(cache.getCreatedCount() - created, 2u);
+		CHECK_EQ(cache.getEntryCount(), std::size_t(1));
+	}
+
+	fixture::removeBase(base);
+
+	return check::result();
+}